@@ -0,0 +1,89 @@
+#include "chunkcache.hpp"
+#include "chunkmap.hpp"
+#include "region.hpp"
+
+#include <list>
+
+using namespace chunkcache;
+
+namespace {
+
+struct Entry {
+	s16vec3 idx;
+	region::EncodedChunk data;
+	u16 connectivity;
+};
+
+// rough size of an entry with its list node and index slot
+size_t entryBytes(Entry const &e) {
+	return sizeof(Entry) + 32 + e.data.runs.size() * sizeof(u16);
+}
+
+struct {
+	std::list<Entry> entries; // most recently stored first
+	ChunkMap<std::list<Entry>::iterator> index;
+	size_t bytes = 0;
+	size_t budget = defaultBudget;
+	Stats stats;
+} cache;
+
+void erase(std::list<Entry>::iterator it) {
+	cache.bytes -= entryBytes(*it);
+	cache.index.erase(chunkKey(it->idx.x, it->idx.y, it->idx.z));
+	cache.entries.erase(it);
+}
+
+void trim() {
+	while (cache.bytes > cache.budget && !cache.entries.empty()) {
+		erase(std::prev(cache.entries.end()));
+		++cache.stats.evictions;
+	}
+}
+
+}
+
+void chunkcache::store(s16vec3 idx, ChunkBlocks const &blocks, u16 connectivity) {
+
+	drop(idx);
+
+	cache.entries.push_front({ idx, region::encode(blocks), connectivity });
+	cache.index[chunkKey(idx.x, idx.y, idx.z)] = cache.entries.begin();
+	cache.bytes += entryBytes(cache.entries.front());
+
+	trim();
+}
+
+bool chunkcache::take(s16vec3 idx, ChunkBlocks &out, u16 &connectivity) {
+
+	auto *found = cache.index.find(chunkKey(idx.x, idx.y, idx.z));
+	if (!found) {
+		++cache.stats.misses;
+		return false;
+	}
+
+	auto entry = *found;
+	bool ok = region::decode(entry->data, out);
+	connectivity = entry->connectivity;
+	erase(entry);
+
+	ok ? ++cache.stats.hits : ++cache.stats.misses;
+	return ok;
+}
+
+void chunkcache::drop(s16vec3 idx) {
+	if (auto *found = cache.index.find(chunkKey(idx.x, idx.y, idx.z)))
+		erase(*found);
+}
+
+Stats chunkcache::getStats() {
+	auto stats = cache.stats;
+	stats.entries = cache.entries.size();
+	stats.bytes = cache.bytes;
+	stats.budget = cache.budget;
+	return stats;
+}
+
+void chunkcache::setBudget(size_t bytes) {
+	cache.budget = bytes;
+	trim();
+}
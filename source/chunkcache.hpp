@@ -0,0 +1,32 @@
+#pragma once
+
+#include "common.hpp"
+
+// recently unloaded chunks that were never edited, kept run-length encoded so that
+// coming back to them costs a decompress instead of a generation; main thread only
+namespace chunkcache {
+
+constexpr size_t defaultBudget = 1 << 20; // bytes
+
+struct Stats {
+	u32 hits = 0;
+	u32 misses = 0;
+	u32 evictions = 0;
+	u32 entries = 0;
+	size_t bytes = 0;
+	size_t budget = 0;
+};
+
+// evicts the least recently stored chunks once over budget
+void store(s16vec3 idx, ChunkBlocks const &blocks, u16 connectivity);
+
+// moves the chunk out of the cache
+bool take(s16vec3 idx, ChunkBlocks &out, u16 &connectivity);
+
+// the chunk got generated again, its copy is of no use anymore
+void drop(s16vec3 idx);
+
+Stats getStats();
+void setBudget(size_t bytes);
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "common.hpp"
+
+// fixed grid of chunks around a moving centre, indexed by chunk coordinates
+// modulo Side; chunks less than Side apart never share a slot. each slot
+// remembers the chunk it holds, so a lookup is an index and one compare.
+// slots never move, so they can be walked while chunks come and go
+template <typename T, int Side, int MinZ, int MaxZ>
+struct ChunkGrid {
+
+	static constexpr int layers = MaxZ - MinZ + 1;
+	static constexpr int size = Side * Side * layers;
+
+	struct Slot {
+		s16vec3 idx;
+		bool used = false;
+		T value {};
+	};
+
+	std::array<Slot, size> slots;
+
+	// offset keeps the operand positive over the whole s16 range
+	static constexpr int wrapOffset = Side * (0x8000 / Side + 1);
+
+	// -1 outside the z range
+	INLINE static int slotIndex(s16 x, s16 y, s16 z) {
+		if (z < MinZ || z > MaxZ)
+			return -1;
+		int sx = (x + wrapOffset) % Side;
+		int sy = (y + wrapOffset) % Side;
+		return sx + (sy + (z - MinZ) * Side) * Side;
+	}
+
+	INLINE T *find(s16 x, s16 y, s16 z) {
+		int i = slotIndex(x, y, z);
+		if (i < 0)
+			return nullptr;
+		auto &s = slots[i];
+		return (s.used && s.idx == s16vec3 { x, y, z }) ? &s.value : nullptr;
+	}
+
+	INLINE T *find(s16vec3 idx) { return find(idx.x, idx.y, idx.z); }
+
+	// whether insert would succeed: the slot is free or already holds idx
+	bool vacant(s16vec3 idx) const {
+		int i = slotIndex(idx.x, idx.y, idx.z);
+		return i >= 0 && (!slots[i].used || slots[i].idx == idx);
+	}
+
+	// the value at idx, default constructed if new; null when another chunk
+	// holds the slot, that one has to be erased first
+	T *insert(s16vec3 idx) {
+		int i = slotIndex(idx.x, idx.y, idx.z);
+		if (i < 0)
+			return nullptr;
+		auto &s = slots[i];
+		if (s.used)
+			return s.idx == idx ? &s.value : nullptr;
+		s.idx = idx;
+		s.used = true;
+		return &s.value;
+	}
+
+	void erase(Slot &s) {
+		s.used = false;
+		s.value = T {};
+	}
+};
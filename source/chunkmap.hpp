@@ -0,0 +1,133 @@
+#pragma once
+#include "common.hpp"
+
+#include <memory>
+
+// chunk and column coordinates packed into 48 bits, 16 per axis
+using ChunkKey = u64;
+
+INLINE constexpr ChunkKey chunkKey(s16 x, s16 y, s16 z = 0) {
+	return (u64)(u16)x | (u64)(u16)y << 16 | (u64)(u16)z << 32;
+}
+
+INLINE constexpr s16vec3 chunkKeyCoords(ChunkKey key) {
+	return { (s16)(u16)key, (s16)(u16)(key >> 16), (s16)(u16)(key >> 32) };
+}
+
+// murmur3 finaliser, every input bit reaches every output bit
+INLINE constexpr u64 mixChunkKey(ChunkKey key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ull;
+	key ^= key >> 33;
+	return key;
+}
+
+// open addressing with linear probing over flat arrays, keys apart from values so
+// a probe only walks the u64 key array; no allocation per entry and no tombstones,
+// erase shifts the rest of the run back. capacity is a power of two, at most 3/4 full
+template <typename V>
+struct ChunkMap {
+
+	static constexpr ChunkKey empty = ~0ull; // never a packed key, those have 48 bits
+
+	INLINE V *find(ChunkKey key) {
+		if (!count)
+			return nullptr;
+		for (u32 i = home(key);; i = (i + 1) & mask) {
+			if (keys[i] == key)
+				return &values[i];
+			if (keys[i] == empty)
+				return nullptr;
+		}
+	}
+
+	INLINE V const *find(ChunkKey key) const {
+		return const_cast<ChunkMap *>(this)->find(key);
+	}
+
+	// default constructed if new
+	V &operator[](ChunkKey key) {
+		if ((count + 1) * 4 > capacity() * 3)
+			rehash(capacity() ? capacity() * 2 : 16);
+		u32 i = home(key);
+		for (; keys[i] != empty; i = (i + 1) & mask)
+			if (keys[i] == key)
+				return values[i];
+		keys[i] = key;
+		values[i] = V {};
+		++count;
+		return values[i];
+	}
+
+	bool erase(ChunkKey key) {
+		if (!count)
+			return false;
+		u32 i = home(key);
+		for (; keys[i] != key; i = (i + 1) & mask)
+			if (keys[i] == empty)
+				return false;
+		// pull back later entries of the run that may sit at or before the hole
+		for (u32 j = (i + 1) & mask; keys[j] != empty; j = (j + 1) & mask) {
+			u32 h = home(keys[j]);
+			if (((j - h) & mask) >= ((j - i) & mask)) {
+				keys[i] = keys[j];
+				values[i] = std::move(values[j]);
+				i = j;
+			}
+		}
+		keys[i] = empty;
+		values[i] = V {};
+		--count;
+		return true;
+	}
+
+	void clear() {
+		for (u32 i = 0; i < capacity(); ++i)
+			if (keys[i] != empty) {
+				keys[i] = empty;
+				values[i] = V {};
+			}
+		count = 0;
+	}
+
+	u32 size() const { return count; }
+	u32 capacity() const { return keys ? mask + 1 : 0; }
+
+	// slots looked at to find key, for benchmarks
+	int probes(ChunkKey key) const {
+		int n = 1;
+		for (u32 i = home(key); keys[i] != key && keys[i] != empty; i = (i + 1) & mask)
+			++n;
+		return n;
+	}
+
+private:
+	std::unique_ptr<ChunkKey[]> keys;
+	std::unique_ptr<V[]> values;
+	u32 mask = 0;
+	u32 count = 0;
+
+	INLINE u32 home(ChunkKey key) const { return mixChunkKey(key) & mask; }
+
+	void rehash(u32 newCapacity) {
+		auto oldKeys = std::move(keys);
+		auto oldValues = std::move(values);
+		u32 oldCapacity = oldKeys ? mask + 1 : 0;
+
+		keys.reset(new ChunkKey[newCapacity]);
+		values.reset(new V[newCapacity]);
+		std::fill(keys.get(), keys.get() + newCapacity, empty);
+		mask = newCapacity - 1;
+
+		for (u32 i = 0; i < oldCapacity; ++i)
+			if (oldKeys[i] != empty) {
+				u32 j = home(oldKeys[i]);
+				while (keys[j] != empty)
+					j = (j + 1) & mask;
+				keys[j] = oldKeys[i];
+				values[j] = std::move(oldValues[i]);
+			}
+	}
+};
@@ -1,10 +1,18 @@
 #pragma once
 
+#ifdef __3DS__
 #include <3ds.h>
 #include <citro3d.h>
+#else
+#include "host.hpp"
+#endif
 #include <stdio.h>
 
+#include "pool.hpp"
+
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <unordered_map>
 #include <vector>
 
@@ -63,12 +71,195 @@ struct Block {
 	int solidId() const { return (value >> 8) & 0x7f; }
 
 	bool operator==(Block const &) const = delete; // do not compare blocks, it does not make sense
-	static Block solid(u16 value) { return { static_cast<u16>(0x8000 | (value << 8)) }; }
-	static Block foliage(u16 value) { return { static_cast<u16>(value << 8) }; }
+	static constexpr Block solid(u16 value) { return { static_cast<u16>(0x8000 | (value << 8)) }; }
+	static constexpr Block foliage(u16 value) { return { static_cast<u16>(value << 8) }; }
 };
 
 using chunk = std::array<std::array<std::array<Block, chunkSize>, chunkSize>, chunkSize>;
 
+constexpr int chunkVolume = chunkSize * chunkSize * chunkSize;
+
+// dense storage with its reference count behind it; only the chunk is handed out,
+// it is the first member so the count can be found from it
+struct DenseChunk {
+	chunk blocks;
+	std::atomic<u32> refs { 1 };
+};
+
+// every dense chunk comes from here, see createChunk and releaseChunk
+inline Pool<DenseChunk, 16> chunkPool;
+
+// with one reference; zeroed, or with whatever the pool slot held before
+INLINE chunk *createChunk(bool zeroed = false) {
+	return &(zeroed ? chunkPool.createZeroed() : chunkPool.create())->blocks;
+}
+
+INLINE std::atomic<u32> &chunkRefs(chunk *c) { return reinterpret_cast<DenseChunk *>(c)->refs; }
+
+// the last reference gives the chunk back to the pool; null is fine
+INLINE void releaseChunk(chunk *c) {
+	if (c && --chunkRefs(c) == 0)
+		chunkPool.destroy(reinterpret_cast<DenseChunk *>(c));
+}
+
+// palette plus bit-packed indices, [z][y][x] like chunk; 1, 2, 4 or 8 bits per
+// block so an index never straddles a word. allocated as one block: header,
+// palette of 1 << bits entries, then the index words. see palette.cpp
+struct PalettedChunk {
+	u8 logBits; // bits per block is 1 << logBits
+	u16 count; // palette entries in use
+	std::atomic<u32> refs;
+
+	INLINE int bits() const { return 1 << logBits; }
+
+	INLINE Block *palette() { return reinterpret_cast<Block *>(this + 1); }
+	INLINE Block const *palette() const { return reinterpret_cast<Block const *>(this + 1); }
+	INLINE u32 *words() { return reinterpret_cast<u32 *>(palette() + (1 << bits())); }
+	INLINE u32 const *words() const { return reinterpret_cast<u32 const *>(palette() + (1 << bits())); }
+
+	INLINE int index(int i) const {
+		int shift = 5 - logBits; // blocks per word as a shift
+		u32 w = words()[i >> shift] >> ((i & ((1 << shift) - 1)) << logBits);
+		return w & ((1u << bits()) - 1);
+	}
+
+	INLINE Block get(int i) const { return palette()[index(i)]; }
+
+	// chunkSize blocks starting at i, a multiple of chunkSize
+	void getRow(int i, Block *out) const;
+
+	// false if the block is not in the palette and the palette is full
+	bool set(int i, Block block);
+
+	size_t bytes() const;
+
+	// with one reference
+	static PalettedChunk *create(int logBits);
+	static PalettedChunk *clone(PalettedChunk const &p);
+	// the last reference frees it; null is fine
+	static void release(PalettedChunk *p);
+
+	// null if the chunk has more than 256 distinct blocks
+	static PalettedChunk *pack(chunk const &data);
+	// same blocks with twice the bits per block, null if already at 8
+	static PalettedChunk *widen(PalettedChunk const &p);
+	void unpack(chunk &out) const;
+};
+
+// block storage of a single chunk; uniform chunks (all air, all stone)
+// do not allocate anything and only keep their fill value, the rest are
+// either a dense array or paletted (see pack). read and write through here.
+// storage is reference counted so other threads can read it through share();
+// set copies it first while it is shared
+struct ChunkBlocks {
+	chunk *dense = nullptr;
+	Block fill { 0 };
+	PalettedChunk *paletted = nullptr;
+
+	INLINE bool isUniform() const { return dense == nullptr && paletted == nullptr; }
+
+	INLINE Block get(int x, int y, int z) const {
+		if (dense)
+			return (*dense)[z][y][x];
+		if (paletted)
+			return paletted->get(x + (y << chunkBits) + (z << (chunkBits * 2)));
+		return fill;
+	}
+
+	// the chunkSize blocks along x at y, z; the fast way to scan a whole chunk
+	void getRow(int y, int z, Block *out) const {
+		if (dense)
+			std::copy((*dense)[z][y].begin(), (*dense)[z][y].end(), out);
+		else if (paletted)
+			paletted->getRow((y << chunkBits) + (z << (chunkBits * 2)), out);
+		else
+			std::fill(out, out + chunkSize, fill);
+	}
+
+	void set(int x, int y, int z, Block block) {
+		if (isShared())
+			unshare();
+		if (paletted) {
+			int i = x + (y << chunkBits) + (z << (chunkBits * 2));
+			while (!paletted->set(i, block)) {
+				auto *wider = PalettedChunk::widen(*paletted);
+				if (!wider) {
+					// past 256 distinct blocks the dense array is smaller
+					dense = createChunk();
+					paletted->unpack(*dense);
+					break;
+				}
+				PalettedChunk::release(paletted);
+				paletted = wider;
+			}
+			if (!dense)
+				return;
+			PalettedChunk::release(paletted);
+			paletted = nullptr;
+		}
+		if (!dense) {
+			if (block.value == fill.value)
+				return;
+			dense = createChunk();
+			for (auto &layer: *dense)
+				for (auto &row: layer)
+					row.fill(fill);
+		}
+		(*dense)[z][y][x] = block;
+	}
+
+	// dense to paletted where that is smaller; worker side, after generation
+	void pack() {
+		if (!dense)
+			return;
+		paletted = PalettedChunk::pack(*dense);
+		if (paletted) {
+			releaseChunk(dense);
+			dense = nullptr;
+		}
+	}
+
+	// another reference to the same blocks, for a reader on another thread;
+	// it sees none of the edits made after this and has to release it
+	ChunkBlocks share() const {
+		if (dense)
+			++chunkRefs(dense);
+		if (paletted)
+			++paletted->refs;
+		return *this;
+	}
+
+	bool isShared() const {
+		return (dense && chunkRefs(dense) > 1) || (paletted && paletted->refs > 1);
+	}
+
+	// own copy of shared storage
+	void unshare() {
+		if (dense) {
+			auto *copy = createChunk();
+			*copy = *dense;
+			releaseChunk(dense);
+			dense = copy;
+		}
+		if (paletted) {
+			auto *copy = PalettedChunk::clone(*paletted);
+			PalettedChunk::release(paletted);
+			paletted = copy;
+		}
+	}
+
+	size_t bytes() const {
+		return dense ? sizeof(chunk) : paletted ? paletted->bytes() : 0;
+	}
+
+	void release() {
+		releaseChunk(dense);
+		dense = nullptr;
+		PalettedChunk::release(paletted);
+		paletted = nullptr;
+	}
+};
+
 struct vertex {
     u8vec3 position;
     u8vec2 texcoord;
@@ -81,26 +81,34 @@ constexpr float RGRADIENTS_3D[] = {
     -11.966937965122034, -44.66122049686031, 0.0, 0
 };
 
+// permutation of a world seed; constexpr so known seeds are baked into the binary,
+// custom seeds take the same path at runtime
 struct Seed {
 
-    std::array<short, PSIZE> perm;
+    std::array<uint8_t, PSIZE> perm {};
+    // last hashing step with the gradient stride already applied, perm[i] & 0xFC
+    std::array<uint8_t, PSIZE> permGrad {};
 
-    int gradIndex(int xrv, int yrv, int zrv) {
-        return perm[perm[perm[xrv & PMASK] ^ (yrv & PMASK)] ^ (zrv & PMASK)] & 0xFC;
+    int gradIndex(int xrv, int yrv, int zrv) const {
+        return permGrad[perm[perm[xrv & PMASK] ^ (yrv & PMASK)] ^ (zrv & PMASK)];
     }
 
-    Seed(int64_t seed) {
-        std::array<short, PSIZE> source;
-        for (short i = 0; i < PSIZE; i++)
+    constexpr Seed(int64_t seed) {
+        // the lcg wraps, so it runs unsigned to stay valid in constant evaluation
+        uint64_t state = seed;
+        std::array<uint8_t, PSIZE> source {};
+        for (int i = 0; i < PSIZE; i++)
             source[i] = i;
         for (int i = PSIZE - 1; i >= 0; i--) {
-            seed = seed * 6364136223846793005L + 1442695040888963407L;
-            int r = (int)((seed + 31) % (i + 1));
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            int r = (int)((int64_t)(state + 31) % (i + 1));
             if (r < 0)
                 r += (i + 1);
             perm[i] = source[r];
             source[r] = source[i];
         }
+        for (int i = 0; i < PSIZE; i++)
+            permGrad[i] = perm[i] & 0xFC;
     }
 };
 
@@ -120,11 +128,11 @@ private:
     float y0, y1, y2, y3;
     float xzFalloff0, xzFalloff1, xzFalloff2, xzFalloff3;
 
-    Seed &seed;
+    Seed const &seed;
 
 public:
 
-    Generator(Seed &seed): seed(seed) {
+    Generator(Seed const &seed): seed(seed) {
         localMinY = std::numeric_limits<float>::infinity();
     }
 
@@ -332,11 +340,151 @@ private:
     float y0, y1, y2, y3;
     float xzFalloff0, xzFalloff1, xzFalloff2, xzFalloff3;
 
-    Seed &seed;
+    Seed const &seed;
+
+    void update(float y) {
+
+        // Domain rotation, finish
+        float yy = y * ROOT3OVER3;
+        float xr = xs + yy;
+        float zr = zs + yy;
+        float yr = xzr + yy;
+
+        // Grid base and bounds
+        int xrb = fastRound(xr), yrb = fastRound(yr), zrb = fastRound(zr);
+        float xri = xr - xrb, yri = yr - yrb, zri = zr - zrb;
+
+        // -1 if positive, 1 if negative
+        int xNSign = (int)(-1.0 - xri) | 1;
+        int yNSign = (int)(-1.0 - yri) | 1;
+        int zNSign = (int)(-1.0 - zri) | 1;
+
+        // Absolute values, using the above
+        float axri = xNSign * -xri;
+        float ayri = yNSign * -yri;
+        float azri = zNSign * -zri;
+
+        for (int l = 0; ; l++)
+        {
+            // Get delta x and z in world-space coordinates away from grid base.
+            // This way we can avoid re-computing the stuff for X and Z, and
+            // only update for Y as Y updates.
+            float s2i = (xri + zri) * -0.211324865405187f - (yri * ROOT3OVER3);
+            float xi0 = xri + s2i;
+            float zi0 = zri + s2i;
+            float yi0 = (xri + zri) * ROOT3OVER3 + (yri * ROOT3OVER3);
+            this->dx0 = xi0; this->dz0 = zi0;
+
+            // Closest vertex on this half-grid
+            int gi = seed.gradIndex(xrb, yrb, zrb);
+
+            // Its gradient and falloff data
+            g0b = RGRADIENTS_3D[gi | 0] * xi0 + RGRADIENTS_3D[gi | 1] * zi0;
+            g0x = RGRADIENTS_3D[gi | 0];
+            g0z = RGRADIENTS_3D[gi | 1];
+            g0y = RGRADIENTS_3D[gi | 2];
+
+            xzFalloff0 = 0.6f - xi0 * xi0 - zi0 * zi0;
+            y0 = y - yi0;
+
+            // Find second-closest vertex
+            if (axri >= ayri && axri >= azri) {
+                gi = seed.gradIndex(xrb - xNSign, yrb, zrb);
+
+                // Position of this vertex, in world-space coordinates
+                float xi = xi0 + xNSign * 0.788675134594813f, zi = zi0 + xNSign * -0.211324865405187f, yi = yi0 + xNSign * ROOT3OVER3;
+                this->dx1 = xi; this->dz1 = zi;
+
+                // Gradient and falloff data
+                g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
+                g1x = RGRADIENTS_3D[gi | 0];
+                g1z = RGRADIENTS_3D[gi | 1];
+                g1y = RGRADIENTS_3D[gi | 2];
+
+                xzFalloff1 = 0.6f - xi * xi - zi * zi;
+                y1 = y - yi;
+
+                // One of the planar boundaries where the state of the seed changes lies between the two
+                // diagonally-opposite vertices on the other half-grid which connect to that half-grid's
+                // closest vertex via edges perpendicular to the edge formed on this half-grid.
+                // We store to localMinY, but we don't yet know if it's the min or the max.
+                // We'll resolve that later.
+                localMinY = y - (ROOT3 / 2) * (yri + zri);
+            } else if (ayri > axri && ayri >= azri) {
+                gi = seed.gradIndex(xrb, yrb - yNSign, zrb);
+                float xi = xi0 + yNSign * -ROOT3OVER3, zi = zi0 + yNSign * -ROOT3OVER3, yi = yi0 + yNSign * ROOT3OVER3;
+                this->dx1 = xi; this->dz1 = zi;
+
+                g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
+                g1x = RGRADIENTS_3D[gi | 0];
+                g1z = RGRADIENTS_3D[gi | 1];
+                g1y = RGRADIENTS_3D[gi | 2];
+
+                xzFalloff1 = 0.6f - xi * xi - zi * zi;
+                y1 = y - yi;
+                localMinY = y - (ROOT3 / 2) * (xri + zri);
+            } else {
+                gi = seed.gradIndex(xrb, yrb, zrb - zNSign);
+                float xi = xi0 + zNSign * -0.211324865405187f, zi = zi0 + zNSign * 0.788675134594813f, yi = yi0 + zNSign * ROOT3OVER3;
+                this->dx1 = xi; this->dz1 = zi;
+
+                g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
+                g1x = RGRADIENTS_3D[gi | 0];
+                g1z = RGRADIENTS_3D[gi | 1];
+                g1y = RGRADIENTS_3D[gi | 2];
+
+                xzFalloff1 = 0.6f - xi * xi - zi * zi;
+                y1 = y - yi;
+                localMinY = y - (ROOT3 / 2) * (xri + yri);
+            }
+
+            if (l == 1) break;
+
+            // Flip everyhing to reference the closest vertex on the other half-grid
+            axri = 0.5f - axri;
+            ayri = 0.5f - ayri;
+            azri = 0.5f - azri;
+            xri = xNSign * axri;
+            yri = yNSign * ayri;
+            zri = zNSign * azri;
+            xrb -= (xNSign >> 1) - (PSIZE / 2);
+            yrb -= (yNSign >> 1) - (PSIZE / 2);
+            zrb -= (zNSign >> 1) - (PSIZE / 2);
+            xNSign = -xNSign;
+            yNSign = -yNSign;
+            zNSign = -zNSign;
+
+            // Shift these over to vacate them for the other iteration.
+            g2b = g0b;
+            g3b = g1b;
+            g2x = g0x;
+            g3x = g1x;
+            g2z = g0z;
+            g3z = g1z;
+            g2y = g0y;
+            g3y = g1y;
+            dx2 = dx0;
+            dx3 = dx1;
+            dz2 = dz0;
+            dz3 = dz1;
+            y2 = y0;
+            y3 = y1;
+            xzFalloff2 = xzFalloff0;
+            xzFalloff3 = xzFalloff1;
+            localMaxY = localMinY;
+        }
+
+        // It isn't guaranteed which will be the min or max, so correct that here.
+        if (localMinY > localMaxY) {
+            float temp = localMaxY;
+            localMaxY = localMinY;
+            localMinY = temp;
+        }
+    }
 
 public:
 
-    DrvGenerator(Seed &seed): seed(seed) {
+    DrvGenerator(Seed const &seed): seed(seed) {
         localMinY = std::numeric_limits<float>::infinity();
     }
 
@@ -352,147 +500,21 @@ public:
         localMinY = std::numeric_limits<float>::infinity();
     }
 
-    void sampleDrv(std::array<float, 4> &values, float y) {
-
-        if (y < localMinY || y > localMaxY) {
-
-            // Domain rotation, finish
-            float yy = y * ROOT3OVER3;
-            float xr = xs + yy;
-            float zr = zs + yy;
-            float yr = xzr + yy;
-
-            // Grid base and bounds
-            int xrb = fastRound(xr), yrb = fastRound(yr), zrb = fastRound(zr);
-            float xri = xr - xrb, yri = yr - yrb, zri = zr - zrb;
-
-            // -1 if positive, 1 if negative
-            int xNSign = (int)(-1.0 - xri) | 1;
-            int yNSign = (int)(-1.0 - yri) | 1;
-            int zNSign = (int)(-1.0 - zri) | 1;
-
-            // Absolute values, using the above
-            float axri = xNSign * -xri;
-            float ayri = yNSign * -yri;
-            float azri = zNSign * -zri;
-
-            for (int l = 0; ; l++)
-            {
-                // Get delta x and z in world-space coordinates away from grid base.
-                // This way we can avoid re-computing the stuff for X and Z, and
-                // only update for Y as Y updates.
-                float s2i = (xri + zri) * -0.211324865405187f - (yri * ROOT3OVER3);
-                float xi0 = xri + s2i;
-                float zi0 = zri + s2i;
-                float yi0 = (xri + zri) * ROOT3OVER3 + (yri * ROOT3OVER3);
-                this->dx0 = xi0; this->dz0 = zi0;
-
-                // Closest vertex on this half-grid
-                int gi = seed.gradIndex(xrb, yrb, zrb);
-
-                // Its gradient and falloff data
-                g0b = RGRADIENTS_3D[gi | 0] * xi0 + RGRADIENTS_3D[gi | 1] * zi0;
-                g0x = RGRADIENTS_3D[gi | 0];
-                g0z = RGRADIENTS_3D[gi | 1];
-                g0y = RGRADIENTS_3D[gi | 2];
-
-                xzFalloff0 = 0.6f - xi0 * xi0 - zi0 * zi0;
-                y0 = y - yi0;
-
-                // Find second-closest vertex
-                if (axri >= ayri && axri >= azri) {
-                    gi = seed.gradIndex(xrb - xNSign, yrb, zrb);
-
-                    // Position of this vertex, in world-space coordinates
-                    float xi = xi0 + xNSign * 0.788675134594813f, zi = zi0 + xNSign * -0.211324865405187f, yi = yi0 + xNSign * ROOT3OVER3;
-                    this->dx1 = xi; this->dz1 = zi;
-
-                    // Gradient and falloff data
-                    g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
-                    g1x = RGRADIENTS_3D[gi | 0];
-                    g1z = RGRADIENTS_3D[gi | 1];
-                    g1y = RGRADIENTS_3D[gi | 2];
-
-                    xzFalloff1 = 0.6f - xi * xi - zi * zi;
-                    y1 = y - yi;
-
-                    // One of the planar boundaries where the state of the seed changes lies between the two
-                    // diagonally-opposite vertices on the other half-grid which connect to that half-grid's
-                    // closest vertex via edges perpendicular to the edge formed on this half-grid.
-                    // We store to localMinY, but we don't yet know if it's the min or the max.
-                    // We'll resolve that later.
-                    localMinY = y - (ROOT3 / 2) * (yri + zri);
-                } else if (ayri > axri && ayri >= azri) {
-                    gi = seed.gradIndex(xrb, yrb - yNSign, zrb);
-                    float xi = xi0 + yNSign * -ROOT3OVER3, zi = zi0 + yNSign * -ROOT3OVER3, yi = yi0 + yNSign * ROOT3OVER3;
-                    this->dx1 = xi; this->dz1 = zi;
-
-                    g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
-                    g1x = RGRADIENTS_3D[gi | 0];
-                    g1z = RGRADIENTS_3D[gi | 1];
-                    g1y = RGRADIENTS_3D[gi | 2];
-
-                    xzFalloff1 = 0.6f - xi * xi - zi * zi;
-                    y1 = y - yi;
-                    localMinY = y - (ROOT3 / 2) * (xri + zri);
-                } else {
-                    gi = seed.gradIndex(xrb, yrb, zrb - zNSign);
-                    float xi = xi0 + zNSign * -0.211324865405187f, zi = zi0 + zNSign * 0.788675134594813f, yi = yi0 + zNSign * ROOT3OVER3;
-                    this->dx1 = xi; this->dz1 = zi;
-
-                    g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
-                    g1x = RGRADIENTS_3D[gi | 0];
-                    g1z = RGRADIENTS_3D[gi | 1];
-                    g1y = RGRADIENTS_3D[gi | 2];
+    // Computes the cell at y even if the cached one covers it, for callers that
+    // choose where each cell is computed; samples up to cellTop() then reuse it.
+    void moveTo(float y) {
+        update(y);
+    }
 
-                    xzFalloff1 = 0.6f - xi * xi - zi * zi;
-                    y1 = y - yi;
-                    localMinY = y - (ROOT3 / 2) * (xri + yri);
-                }
+    float cellTop() const {
+        return localMaxY;
+    }
 
-                if (l == 1) break;
+    void sampleDrv(std::array<float, 4> &values, float y) {
 
-                // Flip everyhing to reference the closest vertex on the other half-grid
-                axri = 0.5f - axri;
-                ayri = 0.5f - ayri;
-                azri = 0.5f - azri;
-                xri = xNSign * axri;
-                yri = yNSign * ayri;
-                zri = zNSign * azri;
-                xrb -= (xNSign >> 1) - (PSIZE / 2);
-                yrb -= (yNSign >> 1) - (PSIZE / 2);
-                zrb -= (zNSign >> 1) - (PSIZE / 2);
-                xNSign = -xNSign;
-                yNSign = -yNSign;
-                zNSign = -zNSign;
+        if (y < localMinY || y > localMaxY)
+            update(y);
 
-                // Shift these over to vacate them for the other iteration.
-                g2b = g0b;
-                g3b = g1b;
-                g2x = g0x;
-                g3x = g1x;
-                g2z = g0z;
-                g3z = g1z;
-                g2y = g0y;
-                g3y = g1y;
-                dx2 = dx0;
-                dx3 = dx1;
-                dz2 = dz0;
-                dz3 = dz1;
-                y2 = y0;
-                y3 = y1;
-                xzFalloff2 = xzFalloff0;
-                xzFalloff3 = xzFalloff1;
-                localMaxY = localMinY;
-            }
-
-            // It isn't guaranteed which will be the min or max, so correct that here.
-            if (localMinY > localMaxY) {
-                float temp = localMaxY;
-                localMaxY = localMinY;
-                localMinY = temp;
-            }
-        }
         float value = 0, dx = 0, dy = 0, dz = 0;
 
         float dy0 = y - y0;
@@ -555,131 +577,9 @@ public:
 
     float sample(float y) {
 
-        if (y < localMinY || y > localMaxY) {
-
-            // Domain rotation, finish
-            float yy = y * ROOT3OVER3;
-            float xr = xs + yy;
-            float zr = zs + yy;
-            float yr = xzr + yy;
-
-            // Grid base and bounds
-            int xrb = fastRound(xr), yrb = fastRound(yr), zrb = fastRound(zr);
-            float xri = xr - xrb, yri = yr - yrb, zri = zr - zrb;
-
-            // -1 if positive, 1 if negative
-            int xNSign = (int)(-1.0 - xri) | 1;
-            int yNSign = (int)(-1.0 - yri) | 1;
-            int zNSign = (int)(-1.0 - zri) | 1;
-
-            // Absolute values, using the above
-            float axri = xNSign * -xri;
-            float ayri = yNSign * -yri;
-            float azri = zNSign * -zri;
+        if (y < localMinY || y > localMaxY)
+            update(y);
 
-            for (int l = 0; ; l++)
-            {
-                // Get delta x and z in world-space coordinates away from grid base.
-                // This way we can avoid re-computing the stuff for X and Z, and
-                // only update for Y as Y updates.
-                float s2i = (xri + zri) * -0.211324865405187f - (yri * ROOT3OVER3);
-                float xi0 = xri + s2i;
-                float zi0 = zri + s2i;
-                float yi0 = (xri + zri) * ROOT3OVER3 + (yri * ROOT3OVER3);
-                this->dx0 = xi0; this->dz0 = zi0;
-
-                // Closest vertex on this half-grid
-                int gi = seed.gradIndex(xrb, yrb, zrb);
-
-                // Its gradient and falloff data
-                g0b = RGRADIENTS_3D[gi | 0] * xi0 + RGRADIENTS_3D[gi | 1] * zi0;
-                g0x = RGRADIENTS_3D[gi | 0]; g0z = RGRADIENTS_3D[gi | 1]; g0y = RGRADIENTS_3D[gi | 2];
-                xzFalloff0 = 0.6f - xi0 * xi0 - zi0 * zi0;
-                y0 = y - yi0;
-
-                // Find second-closest vertex
-                if (axri >= ayri && axri >= azri) {
-                    gi = seed.gradIndex(xrb - xNSign, yrb, zrb);
-
-                    // Position of this vertex, in world-space coordinates
-                    float xi = xi0 + xNSign * 0.788675134594813f, zi = zi0 + xNSign * -0.211324865405187f, yi = yi0 + xNSign * ROOT3OVER3;
-                    this->dx1 = xi; this->dz1 = zi;
-
-                    // Gradient and falloff data
-                    g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
-                    g1x = RGRADIENTS_3D[gi | 0]; g1z = RGRADIENTS_3D[gi | 1]; g1y = RGRADIENTS_3D[gi | 2];
-                    xzFalloff1 = 0.6f - xi * xi - zi * zi;
-                    y1 = y - yi;
-
-                    // One of the planar boundaries where the state of the seed changes lies between the two
-                    // diagonally-opposite vertices on the other half-grid which connect to that half-grid's
-                    // closest vertex via edges perpendicular to the edge formed on this half-grid.
-                    // We store to localMinY, but we don't yet know if it's the min or the max.
-                    // We'll resolve that later.
-                    localMinY = y - (ROOT3 / 2) * (yri + zri);
-                } else if (ayri > axri && ayri >= azri) {
-                    gi = seed.gradIndex(xrb, yrb - yNSign, zrb);
-                    float xi = xi0 + yNSign * -ROOT3OVER3, zi = zi0 + yNSign * -ROOT3OVER3, yi = yi0 + yNSign * ROOT3OVER3;
-                    this->dx1 = xi; this->dz1 = zi;
-                    g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
-                    g1x = RGRADIENTS_3D[gi | 0]; g1z = RGRADIENTS_3D[gi | 1]; g1y = RGRADIENTS_3D[gi | 2];
-                    xzFalloff1 = 0.6f - xi * xi - zi * zi;
-                    y1 = y - yi;
-                    localMinY = y - (ROOT3 / 2) * (xri + zri);
-                } else {
-                    gi = seed.gradIndex(xrb, yrb, zrb - zNSign);
-                    float xi = xi0 + zNSign * -0.211324865405187f, zi = zi0 + zNSign * 0.788675134594813f, yi = yi0 + zNSign * ROOT3OVER3;
-                    this->dx1 = xi; this->dz1 = zi;
-                    g1b = RGRADIENTS_3D[gi | 0] * xi + RGRADIENTS_3D[gi | 1] * zi;
-                    g1x = RGRADIENTS_3D[gi | 0]; g1z = RGRADIENTS_3D[gi | 1]; g1y = RGRADIENTS_3D[gi | 2];
-                    xzFalloff1 = 0.6f - xi * xi - zi * zi;
-                    y1 = y - yi;
-                    localMinY = y - (ROOT3 / 2) * (xri + yri);
-                }
-
-                if (l == 1) break;
-
-                // Flip everyhing to reference the closest vertex on the other half-grid
-                axri = 0.5f - axri;
-                ayri = 0.5f - ayri;
-                azri = 0.5f - azri;
-                xri = xNSign * axri;
-                yri = yNSign * ayri;
-                zri = zNSign * azri;
-                xrb -= (xNSign >> 1) - (PSIZE / 2);
-                yrb -= (yNSign >> 1) - (PSIZE / 2);
-                zrb -= (zNSign >> 1) - (PSIZE / 2);
-                xNSign = -xNSign;
-                yNSign = -yNSign;
-                zNSign = -zNSign;
-
-                // Shift these over to vacate them for the other iteration.
-                g2b = g0b;
-                g3b = g1b;
-                g2x = g0x;
-                g3x = g1x;
-                g2z = g0z;
-                g3z = g1z;
-                g2y = g0y;
-                g3y = g1y;
-                dx2 = dx0;
-                dx3 = dx1;
-                dz2 = dz0;
-                dz3 = dz1;
-                y2 = y0;
-                y3 = y1;
-                xzFalloff2 = xzFalloff0;
-                xzFalloff3 = xzFalloff1;
-                localMaxY = localMinY;
-            }
-
-            // It isn't guaranteed which will be the min or max, so correct that here.
-            if (localMinY > localMaxY) {
-                float temp = localMaxY;
-                localMaxY = localMinY;
-                localMinY = temp;
-            }
-        }
         float value = 0;
 
         float dy0 = y - y0;
@@ -721,5 +621,244 @@ public:
         return value;
     }
 };
+// Fixed point version of DrvGenerator for cores without fast floats.
+// Values are q20; the column position is split into an integer lattice base
+// and a fraction at reset, so large world coordinates do not overflow.
+
+constexpr int FIXED_BITS = 20;
+constexpr int32_t FIXED_ONE = 1 << FIXED_BITS;
+
+constexpr int32_t toFixed(float f) {
+    return (int32_t)(f * FIXED_ONE + (f >= 0 ? 0.5f : -0.5f));
+}
+
+inline int32_t fmul(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b) >> FIXED_BITS);
+}
+
+constexpr auto RGRADIENTS_3D_FIXED = [] {
+    std::array<int32_t, sizeof(RGRADIENTS_3D) / sizeof(float)> table {};
+    for (std::size_t i = 0; i < table.size(); ++i)
+        table[i] = toFixed(RGRADIENTS_3D[i]);
+    return table;
+}();
+
+struct DrvGeneratorFixed {
+
+private:
+
+    static constexpr int32_t SKEW = toFixed(-0.211324865405187f);
+    static constexpr int32_t UNSKEW = toFixed(0.788675134594813f);
+    static constexpr int32_t R3O3 = toFixed(ROOT3OVER3);
+    static constexpr int32_t HALF_ROOT3 = toFixed(ROOT3 / 2);
+    static constexpr int32_t HALF = FIXED_ONE / 2;
+    static constexpr int32_t FALLOFF = toFixed(0.6f);
+
+    int xsBase, zsBase, xzrBase;
+    int32_t xs, zs, xzr;
+    int32_t localMinY, localMaxY;
+
+    int32_t g0b, g0x, g0y, g0z;
+    int32_t g1b, g1x, g1y, g1z;
+    int32_t g2b, g2x, g2y, g2z;
+    int32_t g3b, g3x, g3y, g3z;
+    int32_t dx0, dz0, dx1, dz1;
+    int32_t dx2, dz2, dx3, dz3;
+
+    int32_t y0, y1, y2, y3;
+    int32_t xzFalloff0, xzFalloff1, xzFalloff2, xzFalloff3;
+
+    Seed const &seed;
+
+    static void split(float v, int &base, int32_t &frac) {
+        base = (int)(v >= 0 ? v : v - 1);
+        frac = (int32_t)((v - base) * FIXED_ONE);
+    }
+
+    void update(int32_t y) {
+
+        // Domain rotation, finish
+        int32_t yy = fmul(y, R3O3);
+        int32_t xr = xs + yy;
+        int32_t zr = zs + yy;
+        int32_t yr = xzr + yy;
+
+        // Grid base and bounds
+        int xro = (xr + HALF) >> FIXED_BITS, yro = (yr + HALF) >> FIXED_BITS, zro = (zr + HALF) >> FIXED_BITS;
+        int xrb = xsBase + xro, yrb = xzrBase + yro, zrb = zsBase + zro;
+        int32_t xri = xr - (xro << FIXED_BITS), yri = yr - (yro << FIXED_BITS), zri = zr - (zro << FIXED_BITS);
+
+        // -1 if positive, 1 if negative
+        int xNSign = xri >= 0 ? -1 : 1;
+        int yNSign = yri >= 0 ? -1 : 1;
+        int zNSign = zri >= 0 ? -1 : 1;
+
+        int32_t axri = xNSign * -xri;
+        int32_t ayri = yNSign * -yri;
+        int32_t azri = zNSign * -zri;
+
+        for (int l = 0; ; l++)
+        {
+            int32_t s2i = fmul(xri + zri, SKEW) - fmul(yri, R3O3);
+            int32_t xi0 = xri + s2i;
+            int32_t zi0 = zri + s2i;
+            int32_t yi0 = fmul(xri + zri, R3O3) + fmul(yri, R3O3);
+            dx0 = xi0; dz0 = zi0;
+
+            int gi = seed.gradIndex(xrb, yrb, zrb);
+
+            g0x = RGRADIENTS_3D_FIXED[gi | 0]; g0z = RGRADIENTS_3D_FIXED[gi | 1]; g0y = RGRADIENTS_3D_FIXED[gi | 2];
+            g0b = fmul(g0x, xi0) + fmul(g0z, zi0);
+            xzFalloff0 = FALLOFF - fmul(xi0, xi0) - fmul(zi0, zi0);
+            y0 = y - yi0;
+
+            int32_t xi, zi, yi;
+            if (axri >= ayri && axri >= azri) {
+                gi = seed.gradIndex(xrb - xNSign, yrb, zrb);
+                xi = xi0 + xNSign * UNSKEW; zi = zi0 + xNSign * SKEW; yi = yi0 + xNSign * R3O3;
+                localMinY = y - fmul(HALF_ROOT3, yri + zri);
+            } else if (ayri > axri && ayri >= azri) {
+                gi = seed.gradIndex(xrb, yrb - yNSign, zrb);
+                xi = xi0 - yNSign * R3O3; zi = zi0 - yNSign * R3O3; yi = yi0 + yNSign * R3O3;
+                localMinY = y - fmul(HALF_ROOT3, xri + zri);
+            } else {
+                gi = seed.gradIndex(xrb, yrb, zrb - zNSign);
+                xi = xi0 + zNSign * SKEW; zi = zi0 + zNSign * UNSKEW; yi = yi0 + zNSign * R3O3;
+                localMinY = y - fmul(HALF_ROOT3, xri + yri);
+            }
+            dx1 = xi; dz1 = zi;
+            g1x = RGRADIENTS_3D_FIXED[gi | 0]; g1z = RGRADIENTS_3D_FIXED[gi | 1]; g1y = RGRADIENTS_3D_FIXED[gi | 2];
+            g1b = fmul(g1x, xi) + fmul(g1z, zi);
+            xzFalloff1 = FALLOFF - fmul(xi, xi) - fmul(zi, zi);
+            y1 = y - yi;
+
+            if (l == 1) break;
+
+            // Flip everyhing to reference the closest vertex on the other half-grid
+            axri = HALF - axri;
+            ayri = HALF - ayri;
+            azri = HALF - azri;
+            xri = xNSign * axri;
+            yri = yNSign * ayri;
+            zri = zNSign * azri;
+            xrb -= (xNSign >> 1) - (PSIZE / 2);
+            yrb -= (yNSign >> 1) - (PSIZE / 2);
+            zrb -= (zNSign >> 1) - (PSIZE / 2);
+            xNSign = -xNSign;
+            yNSign = -yNSign;
+            zNSign = -zNSign;
+
+            g2b = g0b; g3b = g1b;
+            g2x = g0x; g3x = g1x;
+            g2z = g0z; g3z = g1z;
+            g2y = g0y; g3y = g1y;
+            dx2 = dx0; dx3 = dx1;
+            dz2 = dz0; dz3 = dz1;
+            y2 = y0; y3 = y1;
+            xzFalloff2 = xzFalloff0;
+            xzFalloff3 = xzFalloff1;
+            localMaxY = localMinY;
+        }
+
+        if (localMinY > localMaxY) {
+            int32_t temp = localMaxY;
+            localMaxY = localMinY;
+            localMinY = temp;
+        }
+    }
+
+    // adds one vertex contribution; returns the falloff term for derivatives, 0 if out of range
+    static inline int32_t contribute(
+        int32_t y, int32_t yv, int32_t xzFalloff, int32_t gb, int32_t gy,
+        int32_t &value, int32_t &ramp, int32_t &falloff, int32_t &dy
+    ) {
+        dy = y - yv;
+        int32_t dySq = fmul(dy, dy);
+        if (xzFalloff <= dySq)
+            return 0;
+        falloff = xzFalloff - dySq;
+        int32_t falloffSq = fmul(falloff, falloff);
+        ramp = gb + fmul(gy, dy);
+        value += fmul(fmul(falloffSq, falloffSq), ramp);
+        return fmul(falloff, falloffSq);
+    }
+
+public:
+
+    DrvGeneratorFixed(Seed const &seed): seed(seed) {
+        localMinY = std::numeric_limits<int32_t>::max();
+    }
+
+    void reset(float x, float z) {
+
+        // Domain rotation, start; done in float once per column
+        float xz = x + z;
+        float s2 = xz * -0.211324865405187f;
+        split(x + s2, xsBase, xs);
+        split(z + s2, zsBase, zs);
+        split(xz * -ROOT3OVER3, xzrBase, xzr);
+
+        localMinY = std::numeric_limits<int32_t>::max();
+    }
+
+    // As in DrvGenerator; y is q20.
+    void moveTo(int32_t y) {
+        update(y);
+    }
+
+    int32_t cellTop() const {
+        return localMaxY;
+    }
+
+    // y and outputs are q20
+    void sampleDrv(std::array<int32_t, 4> &values, int32_t y) {
+
+        if (y < localMinY || y > localMaxY)
+            update(y);
+
+        int32_t value = 0, dx = 0, dy = 0, dz = 0;
+        int32_t ramp, falloff, vdy;
+
+        if (int32_t f3 = contribute(y, y0, xzFalloff0, g0b, g0y, value, ramp, falloff, vdy)) {
+            dx += fmul(fmul(g0x, falloff) - 8 * fmul(ramp, dx0), f3);
+            dy += fmul(fmul(g0y, falloff) - 8 * fmul(ramp, vdy), f3);
+            dz += fmul(fmul(g0z, falloff) - 8 * fmul(ramp, dz0), f3);
+        }
+        if (int32_t f3 = contribute(y, y1, xzFalloff1, g1b, g1y, value, ramp, falloff, vdy)) {
+            dx += fmul(fmul(g1x, falloff) - 8 * fmul(ramp, dx1), f3);
+            dy += fmul(fmul(g1y, falloff) - 8 * fmul(ramp, vdy), f3);
+            dz += fmul(fmul(g1z, falloff) - 8 * fmul(ramp, dz1), f3);
+        }
+        if (int32_t f3 = contribute(y, y2, xzFalloff2, g2b, g2y, value, ramp, falloff, vdy)) {
+            dx += fmul(fmul(g2x, falloff) - 8 * fmul(ramp, dx2), f3);
+            dy += fmul(fmul(g2y, falloff) - 8 * fmul(ramp, vdy), f3);
+            dz += fmul(fmul(g2z, falloff) - 8 * fmul(ramp, dz2), f3);
+        }
+        if (int32_t f3 = contribute(y, y3, xzFalloff3, g3b, g3y, value, ramp, falloff, vdy)) {
+            dx += fmul(fmul(g3x, falloff) - 8 * fmul(ramp, dx3), f3);
+            dy += fmul(fmul(g3y, falloff) - 8 * fmul(ramp, vdy), f3);
+            dz += fmul(fmul(g3z, falloff) - 8 * fmul(ramp, dz3), f3);
+        }
+
+        values[0] = value;
+        values[1] = dx;
+        values[2] = dy;
+        values[3] = dz;
+    }
+
+    int32_t sample(int32_t y) {
+
+        if (y < localMinY || y > localMaxY)
+            update(y);
+
+        int32_t value = 0;
+        int32_t ramp, falloff, vdy;
+        contribute(y, y0, xzFalloff0, g0b, g0y, value, ramp, falloff, vdy);
+        contribute(y, y1, xzFalloff1, g1b, g1y, value, ramp, falloff, vdy);
+        contribute(y, y2, xzFalloff2, g2b, g2y, value, ramp, falloff, vdy);
+        contribute(y, y3, xzFalloff3, g3b, g3y, value, ramp, falloff, vdy);
+        return value;
+    }
+};
 
 }
\ No newline at end of file
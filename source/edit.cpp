@@ -0,0 +1,320 @@
+#include "edit.hpp"
+#include "chunkmap.hpp"
+
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// past this many blocks in one chunk an edit unpacks it and writes rows straight
+// into the dense array, packing it again at the end; fewer go through set
+constexpr int denseEditBlocks = 64;
+
+constexpr u32 allLayers = ((1u << chunkSize) - 1) << 1;
+
+void markChunkRemesh(s16vec3 loc, std::array<u32, 3> const &layers) {
+
+	auto *ch = tryGetChunk(loc.x, loc.y, loc.z);
+	if (!ch) // chunk is not resident, it gets meshed whole when it comes back
+		return;
+
+	if (!ch->isDirty())
+		chunksToRemesh.push_back(loc);
+
+	for (int a = 0; a < 3; ++a)
+		ch->dirty[a] |= layers[a];
+}
+
+// -1 and 1 for the first and last layer of a chunk, 0 inside
+INLINE int border(int c) {
+	return c == 0 ? -1 : c == chunkSize - 1 ? 1 : 0;
+}
+
+// one chunk's part of an edit, collecting what it changed for the remesh
+struct ChunkEdit {
+
+	ChunkMetadata &meta;
+	bool direct; // through ChunkBlocks::set
+	bool repack = false;
+	bool changed = false;
+	std::array<u32, 3> layers {}; // as ChunkMetadata::dirty
+	u32 borders = 0; // regions of the chunk with changes, by neighbourIndex
+
+	ChunkEdit(ChunkMetadata &meta, int blocks) : meta(meta), direct(blocks < denseEditBlocks) {}
+
+	// blocks x0 to x1 of the row at y, z
+	void span(int x0, int x1, int y, int z, Block block) {
+
+		auto &b = meta.blocks;
+		int first = chunkSize, last = -1;
+
+		if (direct || (b.isUniform() && b.fill.value == block.value)) {
+			bool wasDense = b.dense;
+			for (int x = x0; x <= x1; ++x)
+				if (b.get(x, y, z).value != block.value) {
+					b.set(x, y, z, block);
+					first = std::min(first, x);
+					last = x;
+				}
+			// set unpacks uniform chunks, and paletted ones past 256 blocks
+			repack |= !wasDense && b.dense;
+		} else {
+			auto &row = (*dense())[z][y];
+			for (int x = x0; x <= x1; ++x)
+				if (row[x].value != block.value) {
+					row[x] = block;
+					first = std::min(first, x);
+					last = x;
+				}
+		}
+
+		if (last < 0)
+			return;
+
+		changed = true;
+		layers[0] |= (2u << (last + 1)) - (1u << (first + 1));
+		layers[1] |= 1u << (y + 1);
+		layers[2] |= 1u << (z + 1);
+		for (int bx = border(first); bx <= border(last); ++bx)
+			borders |= 1u << neighbourIndex(bx, border(y), border(z));
+	}
+
+	// the whole chunk, dropping its storage
+	void fill(Block block) {
+
+		auto &b = meta.blocks;
+		if (b.isUniform()) {
+			if (b.fill.value == block.value)
+				return;
+			borders = (1u << neighbourhoodSize) - 1;
+		} else
+			// only the neighbours across blocks that change need a remesh
+			for (int z = 0; z < chunkSize; ++z)
+				for (int y = 0; y < chunkSize; ++y) {
+					bool edge = border(y) || border(z);
+					for (int x = 0; x < chunkSize; x += edge ? 1 : chunkMask)
+						if (b.get(x, y, z).value != block.value)
+							borders |= 1u << neighbourIndex(border(x), border(y), border(z));
+				}
+
+		b.release();
+		b.fill = block;
+		repack = false;
+
+		changed = true;
+		layers = { allLayers, allLayers, allLayers };
+	}
+
+	chunk *dense() {
+
+		auto &b = meta.blocks;
+		if (b.dense) {
+			if (b.isShared())
+				b.unshare();
+			return b.dense;
+		}
+
+		auto *d = createChunk();
+		if (b.paletted) {
+			b.paletted->unpack(*d);
+			PalettedChunk::release(b.paletted);
+			b.paletted = nullptr;
+		} else
+			for (auto &layer: *d)
+				for (auto &row: layer)
+					row.fill(b.fill);
+		b.dense = d;
+		repack = true;
+		return d;
+	}
+
+	// 1 when the chunk changed
+	int finish(s16vec3 idx) {
+
+		if (repack)
+			meta.blocks.pack();
+
+		if (!changed)
+			return 0;
+
+		meta.modified = true;
+		// the old connectivity could hide what the edit opened up until the remesh
+		// works it out again, so the chunk counts as open till then
+		meta.connectivity = allFacesConnected;
+
+		// meshes see one block into all 26 neighbours, so changes on a face, edge or
+		// corner of the chunk show up in the neighbours across it
+		u32 neighbours = 0;
+		for (int r = 0; r < neighbourhoodSize; ++r)
+			if (borders & (1u << r)) {
+				int rx = r % 3 - 1, ry = r / 3 % 3 - 1, rz = r / 9 - 1;
+				for (int dz = std::min(rz, 0); dz <= std::max(rz, 0); ++dz)
+					for (int dy = std::min(ry, 0); dy <= std::max(ry, 0); ++dy)
+						for (int dx = std::min(rx, 0); dx <= std::max(rx, 0); ++dx)
+							neighbours |= 1u << neighbourIndex(dx, dy, dz);
+			}
+
+		// the layer next to a neighbour is its outside layer, 0 or chunkSize + 1
+		auto shifted = [&](int a, int d) {
+			return d == 0 ? layers[a] : d < 0 ? 1u << (chunkSize + 1) : 1u;
+		};
+
+		for (int n = 0; n < neighbourhoodSize; ++n)
+			if (neighbours & (1u << n)) {
+				int dx = n % 3 - 1, dy = n / 3 % 3 - 1, dz = n / 9 - 1;
+				markChunkRemesh({ (s16)(idx.x + dx), (s16)(idx.y + dy), (s16)(idx.z + dz) },
+					{ shifted(0, dx), shifted(1, dy), shifted(2, dz) });
+			}
+
+		return 1;
+	}
+};
+
+// chunk by chunk over [lo, hi], in memory order within each. rows(y, z, x0, x1)
+// narrows the blocks of a row to the ones in the shape, false if there are none;
+// covers(lo, hi) is whether the shape holds all of a chunk's blocks
+template <typename Rows, typename Covers>
+int fillShape(vec3<s32> lo, vec3<s32> hi, Block block, Rows rows, Covers covers) {
+
+	int changed = 0;
+
+	int cz0 = std::max(lo.z >> chunkBits, -zChunks), cz1 = std::min(hi.z >> chunkBits, zChunks);
+
+	for (int cz = cz0; cz <= cz1; ++cz)
+		for (int cy = lo.y >> chunkBits; cy <= hi.y >> chunkBits; ++cy)
+			for (int cx = lo.x >> chunkBits; cx <= hi.x >> chunkBits; ++cx) {
+
+				auto *meta = tryGetChunk(cx, cy, cz);
+				if (!meta)
+					continue;
+
+				vec3<s32> base { cx << chunkBits, cy << chunkBits, cz << chunkBits };
+				int x0 = std::max(lo.x - base.x, 0), x1 = std::min(hi.x - base.x, chunkMask);
+				int y0 = std::max(lo.y - base.y, 0), y1 = std::min(hi.y - base.y, chunkMask);
+				int z0 = std::max(lo.z - base.z, 0), z1 = std::min(hi.z - base.z, chunkMask);
+
+				ChunkEdit edit(*meta, (x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1));
+
+				bool whole = !x0 && !y0 && !z0 && x1 == chunkMask && y1 == chunkMask && z1 == chunkMask;
+				if (whole && covers(base, vec3<s32> { base.x + chunkMask, base.y + chunkMask, base.z + chunkMask }))
+					edit.fill(block);
+				else
+					for (int z = z0; z <= z1; ++z)
+						for (int y = y0; y <= y1; ++y) {
+							int from = base.x + x0, to = base.x + x1;
+							if (rows(base.y + y, base.z + z, from, to))
+								edit.span(from - base.x, to - base.x, y, z, block);
+						}
+
+				changed += edit.finish({ (s16)cx, (s16)cy, (s16)cz });
+			}
+
+	return changed;
+}
+
+}
+
+int setBlock(int x, int y, int z, Block block) {
+
+	s16vec3 idx { (s16)(x >> chunkBits), (s16)(y >> chunkBits), (s16)(z >> chunkBits) };
+	auto *meta = tryGetChunk(idx.x, idx.y, idx.z);
+	if (!meta)
+		return 0;
+
+	// the player's edits come one at a time, without the sort setBlocks does
+	ChunkEdit edit(*meta, 1);
+	edit.span(x & chunkMask, x & chunkMask, y & chunkMask, z & chunkMask, block);
+	return edit.finish(idx);
+}
+
+int fillBox(vec3<s32> lo, vec3<s32> hi, Block block) {
+	return fillShape(lo, hi, block,
+		[](int, int, int &, int &) { return true; },
+		[](vec3<s32>, vec3<s32>) { return true; });
+}
+
+int fillSphere(vec3<s32> centre, int radius, Block block) {
+
+	s32 r2 = radius * radius;
+
+	auto rows = [&](int y, int z, int &x0, int &x1) {
+		s32 rest = r2 - (y - centre.y) * (y - centre.y) - (z - centre.z) * (z - centre.z);
+		if (rest < 0)
+			return false;
+		int w = sqrtf(rest);
+		while ((w + 1) * (w + 1) <= rest)
+			++w;
+		while (w * w > rest)
+			--w;
+		x0 = std::max(x0, centre.x - w);
+		x1 = std::min(x1, centre.x + w);
+		return x0 <= x1;
+	};
+
+	// the corner furthest from the centre
+	auto covers = [&](vec3<s32> lo, vec3<s32> hi) {
+		auto far = [](s32 lo, s32 hi, s32 c) { return std::max(c - lo, hi - c); };
+		s32 dx = far(lo.x, hi.x, centre.x), dy = far(lo.y, hi.y, centre.y), dz = far(lo.z, hi.z, centre.z);
+		return dx * dx + dy * dy + dz * dz <= r2;
+	};
+
+	vec3<s32> lo { centre.x - radius, centre.y - radius, centre.z - radius };
+	vec3<s32> hi { centre.x + radius, centre.y + radius, centre.z + radius };
+	return fillShape(lo, hi, block, rows, covers);
+}
+
+int setBlocks(std::span<BlockEdit> edits) {
+
+	auto chunkOf = [](BlockEdit const &e) {
+		return chunkKey(e.x >> chunkBits, e.y >> chunkBits, e.z >> chunkBits);
+	};
+
+	// counting sort by chunk; edits keep their order within one, so the last still wins
+	ChunkMap<u32> buckets; // chunk to its bucket, plus one
+	std::vector<ChunkKey> chunks;
+	std::vector<u32> starts;
+	std::vector<u32> bucketOf(edits.size());
+
+	for (size_t i = 0; i < edits.size(); ++i) {
+		auto &b = buckets[chunkOf(edits[i])];
+		if (!b) {
+			chunks.push_back(chunkOf(edits[i]));
+			starts.push_back(0);
+			b = chunks.size();
+		}
+		bucketOf[i] = b - 1;
+		++starts[b - 1];
+	}
+
+	u32 at = 0;
+	for (auto &s: starts)
+		at += std::exchange(s, at);
+	starts.push_back(at);
+
+	std::vector<BlockEdit> sorted(edits.size());
+	for (size_t i = 0; i < edits.size(); ++i)
+		sorted[starts[bucketOf[i]]++] = edits[i];
+	std::copy(sorted.begin(), sorted.end(), edits.begin());
+
+	// starts now holds where each bucket ends
+	int changed = 0;
+
+	for (size_t c = 0; c < chunks.size(); ++c) {
+
+		auto idx = chunkKeyCoords(chunks[c]);
+		auto *meta = tryGetChunk(idx.x, idx.y, idx.z);
+		if (!meta)
+			continue;
+
+		u32 begin = c ? starts[c - 1] : 0, end = starts[c];
+		ChunkEdit edit(*meta, end - begin);
+		for (u32 i = begin; i < end; ++i) {
+			auto &e = edits[i];
+			int x = e.x & chunkMask;
+			edit.span(x, x, e.y & chunkMask, e.z & chunkMask, e.block);
+		}
+		changed += edit.finish(idx);
+	}
+
+	return changed;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <span>
+
+// block edits on resident chunks, for the player, explosions, structures and tools.
+// blocks are written chunk by chunk; each changed chunk is queued for one remesh of
+// the layers that changed, which also works out its connectivity again, along with
+// the neighbours whose border it reaches. chunks that are not resident are skipped.
+// all of them return the number of chunks changed
+
+struct BlockEdit {
+	s32 x, y, z;
+	Block block;
+};
+
+// chunks with dirty layers waiting for a remesh; a chunk is listed when it turns dirty,
+// so edits landing in it do not add more. an entry that has gone stale can still be
+// listed beside a new one, scheduleMarkedRemeshes drops such duplicates
+inline std::vector<s16vec3> chunksToRemesh; // todo bounded array?
+
+int setBlock(int x, int y, int z, Block block);
+
+// bounds are inclusive
+int fillBox(vec3<s32> lo, vec3<s32> hi, Block block);
+
+// blocks whose centre is within radius of the centre block's
+int fillSphere(vec3<s32> centre, int radius, Block block);
+
+// grouped in place by chunk, keeping their order within each; the last edit of a block wins
+int setBlocks(std::span<BlockEdit> edits);
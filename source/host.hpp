@@ -0,0 +1,44 @@
+#pragma once
+
+// just enough of libctru to build the world generator on a desktop; see tools/Makefile
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+#define SYSCLOCK_ARM11 268111856
+
+// ticks at the 3ds arm11 rate, so timings read the same on both
+inline u64 svcGetSystemTick() {
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	return (u64)(ns * (SYSCLOCK_ARM11 / 1e9));
+}
+
+// worldgen locks its column cache; the 3ds LightLock maps onto a std::mutex here
+#include <mutex>
+
+struct LightLock { std::mutex m; };
+
+inline void LightLock_Init(LightLock *) {}
+inline void LightLock_Lock(LightLock *lock) { lock->m.lock(); }
+inline void LightLock_Unlock(LightLock *lock) { lock->m.unlock(); }
+
+// the mesher hands its buffers to the gpu through linear memory; plain heap here
+#include <cstdlib>
+#include <cstring>
+
+inline void *linearAlloc(size_t size) { return malloc(size); }
+inline void linearFree(void *mem) { free(mem); }
+
+// resident chunks keep the gpu buffer layout of their mesh; never touched off the 3ds
+struct C3D_BufInfo {};
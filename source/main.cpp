@@ -1,4 +1,5 @@
 #include <3ds.h>
+#include <algorithm>
 #include <cmath>
 #include <stdio.h>
 
@@ -8,61 +9,54 @@
 
 #include "scheduler.hpp"
 #include "player.hpp"
+#include "region.hpp"
+#include "chunkcache.hpp"
+#include "chunkmap.hpp"
+#include "edit.hpp"
 
 Player player;
 
 vec3<s32> playerFocus;
 bool drawFocus = false;
 
-std::vector<s16vec3> chunksToRemesh; // todo bounded array?
-void markChunkRemesh(s16vec3 loc) {
-
-	for (auto &idx : chunksToRemesh)
-		if (idx == loc)
-			return;
-
-	chunksToRemesh.push_back(loc);
-}
-
 void scheduleMarkedRemeshes() {
 
-	while (chunksToRemesh.size()) {
+	// an entry outlives its dirty layers when a whole mesh clears them first, and the
+	// next edit to the chunk lists it again; one entry a chunk is enough
+	if (chunksToRemesh.size() > 1) {
+		auto byKey = [](s16vec3 a, s16vec3 b) { return chunkKey(a.x, a.y, a.z) < chunkKey(b.x, b.y, b.z); };
+		std::sort(chunksToRemesh.begin(), chunksToRemesh.end(), byKey);
+		chunksToRemesh.erase(std::unique(chunksToRemesh.begin(), chunksToRemesh.end()), chunksToRemesh.end());
+	}
+
+	for (size_t i = 0; i < chunksToRemesh.size();) {
 
 		if (!canProcessMeshes(true))
 			return;
 
-		auto &idx = chunksToRemesh.back();
-		chunksToRemesh.pop_back(); // todo: it explodes without it, investigate
-		auto ch = tryGetChunk(idx.x, idx.y, idx.z);
-
-		if (!ch) // chunk is not resident, so just ignore it
-			return;
+		auto idx = chunksToRemesh[i];
+		auto *ch = tryGetChunk(idx.x, idx.y, idx.z);
+
+		bool done = true;
+		if (ch && ch->isDirty()) {
+			if (isMeshScheduled(idx))
+				done = false; // its patch has to wait for the mesh in flight
+			else if (!ch->meshed)
+				ch->dirty = {}; // the first mesh takes the whole chunk anyway
+			else
+				done = regenerateMesh(*ch, idx.x, idx.y, idx.z);
+		}
 
-		regenerateMesh(*ch, idx.x, idx.y, idx.z);
+		if (done) {
+			chunksToRemesh[i] = chunksToRemesh.back();
+			chunksToRemesh.pop_back();
+		} else
+			++i;
 	}
 }
 
 inline s16vec3 _sv(s16 x, s16 y, s16 z) { return { x, y, z }; }
 
-// we have idx by now anyway...
-void markBlockDirty(int sx, int sy, int sz, s16vec3 chunkIdx) {
-
-	markChunkRemesh(chunkIdx);
-
-	if (sx == 0)
-		markChunkRemesh(_sv(chunkIdx.x - 1, chunkIdx.y, chunkIdx.z));
-	if (sx == chunkSize - 1)
-		markChunkRemesh(_sv(chunkIdx.x + 1, chunkIdx.y, chunkIdx.z));
-	if (sy == 0)
-		markChunkRemesh(_sv(chunkIdx.x, chunkIdx.y - 1, chunkIdx.z));
-	if (sy == chunkSize - 1)
-		markChunkRemesh(_sv(chunkIdx.x, chunkIdx.y + 1, chunkIdx.z));
-	if (sz == 0)
-		markChunkRemesh(_sv(chunkIdx.x, chunkIdx.y, chunkIdx.z - 1));
-	if (sz == chunkSize - 1)
-		markChunkRemesh(_sv(chunkIdx.x, chunkIdx.y, chunkIdx.z + 1));
-}
-
 u16 selectedBlock = 0;
 
 void handleTouch() {
@@ -113,36 +107,16 @@ void handlePlayer(float delta) {
 			int ny = playerFocus.y + normal.y;
 			int nz = playerFocus.z + normal.z;
 
-			auto idx = _sv(nx >> chunkBits, ny >> chunkBits, nz >> chunkBits);
-			auto *ch = tryGetChunk(idx.x, idx.y, idx.z);
-
-			if (ch) {
-				int lx = nx & chunkMask, ly = ny & chunkMask, lz = nz & chunkMask;
-				(*ch->data)[lz][ly][lx] = Block::solid(selectedBlock);
-				markBlockDirty(lx, ly, lz, idx);
-			}
+			setBlock(nx, ny, nz, Block::solid(selectedBlock));
 		}
 
 		if (kDown & (KEY_X | KEY_L)) {
-			int nx = playerFocus.x;
-			int ny = playerFocus.y;
-			int nz = playerFocus.z;
-
-			auto idx = _sv(nx >> chunkBits, ny >> chunkBits, nz >> chunkBits);
-			auto *ch = tryGetChunk(idx.x, idx.y, idx.z);
-
-			if (ch) {
-				int lx = nx & chunkMask, ly = ny & chunkMask, lz = nz & chunkMask;
-				(*ch->data)[lz][ly][lx] = { 0 };
-				markBlockDirty(lx, ly, lz, idx);
-			}
+			setBlock(playerFocus.x, playerFocus.y, playerFocus.z, { 0 });
 		}
 		drawFocus = true;
 	}
 }
 
-void invalidateWorldIterator();
-
 void processWorkerResults() {
 
 	TaskResult r;
@@ -152,29 +126,70 @@ void processWorkerResults() {
 			case TaskResult::Type::ChunkData: {
 
 				s16vec3 idx = { r.chunk.x, r.chunk.y, r.chunk.z };
-				auto oldBuckets = world.bucket_count();
-				auto &meta = world[idx];
+				scheduledChunkReceived(idx);
+				chunkcache::drop(idx);
 
-				// this will cancel iterative unloading if it is progress
-				if (world.bucket_count() != oldBuckets)
-					invalidateWorldIterator();
+				// column jobs regenerate chunks that stayed loaded; keep the loaded one, it may be edited.
+				// the player may also have moved on, leaving the slot to a nearer chunk
+				if (world.find(idx) || !world.vacant(idx)) {
+					ChunkBlocks { r.chunk.data, r.chunk.fill, r.chunk.paletted }.release();
+					break;
+				}
 
-				scheduledChunkReceived(idx);
-				meta.data = r.chunk.data;
-				meta.visibility = r.chunk.visibility;
+				auto &meta = *world.insert(idx);
+
+				meta.blocks.dense = r.chunk.data;
+				meta.blocks.fill = r.chunk.fill;
+				meta.blocks.paletted = r.chunk.paletted;
+				meta.connectivity = r.chunk.connectivity;
 			} break;
 
 			case TaskResult::Type::ChunkMesh: {
 				s16vec3 idx = { r.chunk.x, r.chunk.y, r.chunk.z };
-				auto &meta = world[idx];
+				scheduledMeshReceived(idx);
+
+				// chunk got unloaded while meshing; do not resurrect it without data
+				auto *found = world.find(idx);
+				if (!found) {
+					freeMesh(*r.chunk.alloc);
+					meshAllocationPool.destroy(r.chunk.alloc);
+					break;
+				}
+				auto &meta = *found;
+
+				// a patch of a few segments, put it in place of those in the current mesh
+				if (!r.chunk.alloc->segments.all()) {
+					if (!meta.meshed) { // unloaded and back meanwhile, there is nothing to patch
+						freeMesh(*r.chunk.alloc);
+						meshAllocationPool.destroy(r.chunk.alloc);
+						break;
+					}
+					if (!meshLost(meta.allocation) && !meshLost(*r.chunk.alloc)) {
+						auto spliced = spliceMesh(meta.allocation, *r.chunk.alloc);
+						freeMesh(*r.chunk.alloc);
+						*r.chunk.alloc = std::move(spliced);
+					}
+				}
+
+				// linear memory ran out for this mesh or the one it patches; the chunk goes
+				// back to unmeshed and is meshed whole again
+				if (meshLost(*r.chunk.alloc) || !r.chunk.alloc->segments.all()) {
+					freeMesh(*r.chunk.alloc);
+					meshAllocationPool.destroy(r.chunk.alloc);
+					freeMesh(meta.allocation);
+					meta.allocation = {};
+					meta.meshed = false;
+					break;
+				}
 
 				if (meta.allocation.vertexCount)
 					freeMesh(meta.allocation);
 
 				meta.allocation = std::move(*r.chunk.alloc);
 
-				if (r.flags & TaskResult::RESULT_VISIBILITY)
-					meta.visibility = r.chunk.visibility;
+				// a chunk edited again since the task was sent stays open for the next remesh
+				if (r.flags & TaskResult::RESULT_VISIBILITY && !meta.isDirty())
+					meta.connectivity = r.chunk.connectivity;
 
 				if (meta.allocation.vertexCount) {
 					BufInfo_Init(&meta.vertexBuffer);
@@ -182,9 +197,7 @@ void processWorkerResults() {
 				}
 
 				meta.meshed = true;
-				delete r.chunk.alloc;
-
-				scheduledMeshReceived(idx);
+				meshAllocationPool.destroy(r.chunk.alloc);
 
 			} break;
 
@@ -192,10 +205,6 @@ void processWorkerResults() {
 		}
 }
 
-// note that a 1-chunk thick shell will generate outside the render cage since it is needed for meshing
-static constexpr int distanceLoad = 6; // blocks to load, cage size 2n+1
-static constexpr int distanceUnload = 8; // blocks to unload, keep blocks in cage of 2n+1
-
 enum class WMStatus {
 	Idle,
 	UnloadDistance,
@@ -206,18 +215,13 @@ struct {
 	int chX, chY, chZ;
 
 	std::vector<Result> pendingResults;
-	WorldMap::iterator checkToErase;
+	int checkToErase; // slot index
 	std::vector<s16vec3> checkToLoad;
 
 	WMStatus status = WMStatus::Idle;
 
 } wm;
 
-void invalidateWorldIterator() {
-	if (wm.status == WMStatus::UnloadDistance)
-		wm.status = WMStatus::LoadVisible;
-}
-
 constexpr u32 maxWMTime = SYSCLOCK_ARM11 / 1000; // 1ms per frame
 
 void wmSchedule(fvec3 focus) {
@@ -228,7 +232,7 @@ void wmSchedule(fvec3 focus) {
 
 	wm.checkToLoad.clear();
 
-	wm.checkToErase = world.begin();
+	wm.checkToErase = 0;
 
 	for (int z = wm.chZ - distanceLoad; z <= wm.chZ + distanceLoad; ++z)
 		for (int y = wm.chY - distanceLoad; y <= wm.chY + distanceLoad; ++y)
@@ -241,20 +245,18 @@ void wmSchedule(fvec3 focus) {
 
 
 inline void wmUnload() {
-	auto &it = wm.checkToErase;
-	if (wm.checkToErase != world.end()) {
-		auto &idx = it->first;
-		if (
+	if (wm.checkToErase < WorldMap::size) {
+		auto &slot = world.slots[wm.checkToErase++];
+		auto &idx = slot.idx;
+		if (slot.used && (
 			idx.x < wm.chX - distanceUnload ||
 			idx.x > wm.chX + distanceUnload ||
 			idx.y < wm.chY - distanceUnload ||
 			idx.y > wm.chY + distanceUnload ||
-			idx.y < wm.chY - distanceUnload ||
+			idx.z < wm.chZ - distanceUnload ||
 			idx.z > wm.chZ + distanceUnload
-		)
-			it = destroyChunk(it);
-		else
-			++it;
+		))
+			destroyChunk(slot);
 	}
 	else
 		wm.status = WMStatus::LoadVisible;
@@ -380,6 +382,9 @@ int main() {
 		console = true;
 
 	renderInit(!console);
+
+	// optional, see tools/pregen; everything outside it is generated as usual
+	region::open("romfs:/region.bin");
 	startWorker();
 
 	tick = svcGetSystemTick();
@@ -400,10 +405,11 @@ int main() {
 
 	stopWorker(); // halt processing, submit leftover jobs as results
 	processWorkerResults(); // accept all results so they do not leak
+	region::close();
 
-	for (auto &[idx, meta]: world)
-		if (meta.meshed)
-			freeMesh(meta.allocation);
+	for (auto &slot: world.slots)
+		if (slot.used && slot.value.meshed)
+			freeMesh(slot.value.allocation);
 
 	renderExit();
 
@@ -153,17 +153,25 @@ template <> struct AxisAccessor<3> : FaceYAccessor<ReverseAccessor, ForwardAcces
 template <> struct AxisAccessor<4> : FaceZAccessor<ReverseAccessor, ForwardAccessor, ReverseAccessor> {};
 template <> struct AxisAccessor<5> : FaceZAccessor<ForwardAccessor, ForwardAccessor, ForwardAccessor> {};
 
+using SegmentStarts = std::array<u16, meshSegments + 1>;
+
 template <int s>
 INLINE void meshFace(
 	expandedChunk const &cch,
 	std::vector<vertex> &vertices,
-	std::array<std::vector<u16>, blockTextureCount> &isPerTexture
+	std::array<std::vector<u16>, blockTextureCount> &isPerTexture,
+	MeshSegments const &segments,
+	SegmentStarts &starts
 ) {
 	using a = AxisAccessor<s>;
 	std::array<u16, (chunkSize+1) * (chunkSize+1)> vertexCache;
 
 	for (int l = 0; l < chunkSize; ++l) { // layer
 
+		starts[s * chunkSize + l] = vertices.size();
+		if (!segments[s * chunkSize + l])
+			continue;
+
 		for (int i = 0; i < (chunkSize+1) * (chunkSize+1); ++i)
 			vertexCache[i] = 0xffff;
 
@@ -261,9 +269,14 @@ INLINE void meshFace(
 INLINE void meshFoliage(
 	expandedChunk const &cch,
 	std::vector<vertex> &vertices,
-	std::array<std::vector<u16>, blockTextureCount> &isPerTexture
+	std::array<std::vector<u16>, blockTextureCount> &isPerTexture,
+	MeshSegments const &segments,
+	SegmentStarts &starts
 ) {
-	for (int z = 0; z < chunkSize; ++z)
+	for (int z = 0; z < chunkSize; ++z) {
+		starts[6 * chunkSize + z] = vertices.size();
+		if (!segments[6 * chunkSize + z])
+			continue;
 		for (int y = 0; y < chunkSize; ++y)
 			for (int x = 0; x < chunkSize; ++x) {
 				auto b = cch[z+1][y+1][x+1];
@@ -293,20 +306,14 @@ INLINE void meshFoliage(
 					}
 				}
 			}
+	}
 }
 
-MesherAllocation meshChunk(expandedChunk const &cch) {
-	std::vector<vertex> vertices;
-	std::array<std::vector<u16>, blockTextureCount> isPerTexture;
-
-	meshFace<0>(cch, vertices, isPerTexture);
-	meshFace<1>(cch, vertices, isPerTexture);
-	meshFace<2>(cch, vertices, isPerTexture);
-	meshFace<3>(cch, vertices, isPerTexture);
-	meshFace<4>(cch, vertices, isPerTexture);
-	meshFace<5>(cch, vertices, isPerTexture);
-	meshFoliage(cch, vertices, isPerTexture);
-
+// copies the geometry to linear memory
+MesherAllocation uploadMesh(
+	std::vector<vertex> const &vertices,
+	std::array<std::vector<u16>, blockTextureCount> const &isPerTexture
+) {
 	MesherAllocation result;
 	std::vector<u16> indicesFlat;
 
@@ -350,54 +357,189 @@ MesherAllocation meshChunk(expandedChunk const &cch) {
 	return result;
 }
 
-// todo: we probably do not need this one with the task system
-MesherAllocation meshChunk(chunk const &ch, std::array<chunk *, 6> const &sides) {
-
-	// -x, +x, -y, +y, -z, +z
-	expandedChunk cch = {0};
-	expandChunk(ch, sides, cch);
-	return meshChunk(cch);
+MesherAllocation meshChunk(expandedChunk const &cch, MeshSegments const &segments) {
+	std::vector<vertex> vertices;
+	std::array<std::vector<u16>, blockTextureCount> isPerTexture;
+	SegmentStarts starts;
+
+	meshFace<0>(cch, vertices, isPerTexture, segments, starts);
+	meshFace<1>(cch, vertices, isPerTexture, segments, starts);
+	meshFace<2>(cch, vertices, isPerTexture, segments, starts);
+	meshFace<3>(cch, vertices, isPerTexture, segments, starts);
+	meshFace<4>(cch, vertices, isPerTexture, segments, starts);
+	meshFace<5>(cch, vertices, isPerTexture, segments, starts);
+	meshFoliage(cch, vertices, isPerTexture, segments, starts);
+	starts[meshSegments] = vertices.size();
+
+	auto result = uploadMesh(vertices, isPerTexture);
+	result.segmentVertices = starts;
+	result.segments = segments;
+	return result;
 }
 
-void expandChunk(chunk const &ch, std::array<chunk *, 6> const &sides, expandedChunk &ex) {
+MeshSegments dirtySegments(std::array<u32, 3> const &dirtyLayers) {
+
+	MeshSegments segments;
+
+	// faces of layer l sit on blocks at c and look at c + dir, both shifted by one for the masks;
+	// even face directions look down their axis and walk it backwards
+	for (int s = 0; s < 6; ++s) {
+		u32 layers = dirtyLayers[s / 2];
+		int dir = (s & 1) ? 1 : -1;
+		for (int l = 0; l < chunkSize; ++l) {
+			int c = dir > 0 ? l : chunkSize - 1 - l;
+			if (layers & (1u << (c + 1) | 1u << (c + dir + 1)))
+				segments.set(s * chunkSize + l);
+		}
+	}
 
 	for (int z = 0; z < chunkSize; ++z)
-		for (int y = 0; y < chunkSize; ++y)
-			for (int x = 0; x < chunkSize; ++x)
-				ex[z + 1][y + 1][x + 1] = ch[z][y][x];
+		if (dirtyLayers[2] & (1u << (z + 1)))
+			segments.set(6 * chunkSize + z);
+
+	return segments;
+}
 
-	// organise this somehow...
-	if (sides[0]) // -x
-		for (int z = 0; z < chunkSize; ++z)
-			for (int y = 0; y < chunkSize; ++y)
-				ex[z + 1][y + 1][0] = (*sides[0])[z][y][chunkSize-1];
+MesherAllocation spliceMesh(MesherAllocation const &base, MesherAllocation const &patch) {
 
-	if (sides[1]) // +x
-		for (int z = 0; z < chunkSize; ++z)
-			for (int y = 0; y < chunkSize; ++y)
-				ex[z + 1][y + 1][chunkSize+1] = (*sides[1])[z][y][0];
+	auto source = [&](int seg) -> MesherAllocation const & {
+		return patch.segments[seg] ? patch : base;
+	};
 
-	if (sides[2]) // -y
-		for (int z = 0; z < chunkSize; ++z)
-			for (int x = 0; x < chunkSize; ++x)
-				ex[z + 1][0][x + 1] = (*sides[2])[z][chunkSize-1][x];
+	MesherAllocation result;
+	result.segments.set();
+
+	auto &starts = result.segmentVertices;
+	int vertexCount = 0;
+	for (int seg = 0; seg < meshSegments; ++seg) {
+		auto &from = source(seg);
+		starts[seg] = vertexCount;
+		vertexCount += from.segmentVertices[seg + 1] - from.segmentVertices[seg];
+	}
+	starts[meshSegments] = vertexCount;
+
+	// index ranges of each texture in both
+	struct Range { u16 const *at, *end; };
+	auto ranges = [](MesherAllocation const &m, int &count) {
+		std::array<Range, blockTextureCount> r {};
+		auto *i = static_cast<u16 const *>(m.indices);
+		for (auto &mesh: m.meshes) {
+			r[mesh.texture] = { i, i + mesh.count };
+			i += mesh.count;
+		}
+		count = i - static_cast<u16 const *>(m.indices);
+		return r;
+	};
+	int baseIndices = 0, patchIndices = 0;
+	auto baseRanges = ranges(base, baseIndices), patchRanges = ranges(patch, patchIndices);
+
+	if (!vertexCount)
+		return result;
+
+	// enough for both, so indices can be written straight into linear memory
+	result.vertexCount = vertexCount;
+	result.vertices = linearAlloc(vertexCount * sizeof(vertex));
+	result.indices = linearAlloc((baseIndices + patchIndices) * sizeof(u16));
+	if (!result.vertices || !result.indices) {
+		printf("failed linear allocation\n");
+		freeMesh(result);
+		result.vertices = result.indices = nullptr;
+		return result;
+	}
 
-	if (sides[3]) // +y
-		for (int z = 0; z < chunkSize; ++z)
-			for (int x = 0; x < chunkSize; ++x)
-				ex[z + 1][chunkSize+1][x + 1] = (*sides[3])[z][0][x];
+	auto *vertices = static_cast<vertex *>(result.vertices);
+	for (int seg = 0; seg < meshSegments; ++seg) {
+		auto &from = source(seg);
+		auto *v = static_cast<vertex const *>(from.vertices);
+		std::copy(v + from.segmentVertices[seg], v + from.segmentVertices[seg + 1], vertices + starts[seg]);
+	}
 
-	if (sides[4]) // -z
-		for (int y = 0; y < chunkSize; ++y)
-			for (int x = 0; x < chunkSize; ++x)
-				ex[0][y + 1][x + 1] = (*sides[4])[chunkSize-1][y][x];
+	auto *out = static_cast<u16 *>(result.indices);
 
-	if (sides[5]) // -z
-		for (int y = 0; y < chunkSize; ++y)
-			for (int x = 0; x < chunkSize; ++x)
-				ex[chunkSize+1][y + 1][x + 1] = (*sides[5])[0][y][x];
+	// moves r past the indices of the segment, keeping them rebased if asked
+	auto walk = [&](Range &r, MesherAllocation const &from, int seg, bool keep) {
+		u16 end = from.segmentVertices[seg + 1];
+		int offset = starts[seg] - from.segmentVertices[seg];
+		for (; r.at != r.end && *r.at < end; ++r.at)
+			if (keep)
+				*out++ = *r.at + offset;
+	};
+
+	for (int t = 0; t < blockTextureCount; ++t) {
+		auto &b = baseRanges[t], &p = patchRanges[t];
+		auto *first = out;
+		for (int seg = 0; seg < meshSegments && (b.at != b.end || p.at != p.end); ++seg) {
+			walk(b, base, seg, !patch.segments[seg]);
+			walk(p, patch, seg, patch.segments[seg]);
+		}
+		if (out != first)
+			result.meshes.push_back({ (u16)(out - first), (u8)t, (u8)(t == 28 ? 0b11 : 0) });
+	}
+
+	return result;
 }
 
+// todo: we probably do not need this one with the task system
+MesherAllocation meshChunk(ChunkNeighbourhood const &chunks) {
+
+	expandedChunk cch;
+	expandChunk(chunks, cch);
+	return meshChunk(cch);
+}
+
+// the part of a neighbour that borders the centre, as one strided copy: per axis the
+// last layer below the centre, the whole span or the first layer above it
+void copyNeighbour(ChunkBlocks const *ch, int dx, int dy, int dz, expandedChunk &ex) {
+
+	auto range = [](int d, int &src, int &dst, int &count) {
+		src = d < 0 ? chunkSize - 1 : 0;
+		dst = d < 0 ? 0 : d > 0 ? chunkSize + 1 : 1;
+		count = d ? 1 : chunkSize;
+	};
+	int sx, sy, sz, ex0, ey0, ez0, nx, ny, nz;
+	range(dx, sx, ex0, nx);
+	range(dy, sy, ey0, ny);
+	range(dz, sz, ez0, nz);
+
+	for (int z = 0; z < nz; ++z)
+		for (int y = 0; y < ny; ++y) {
+			Block *out = &ex[ez0 + z][ey0 + y][ex0];
+			if (!ch)
+				std::fill(out, out + nx, Block { 0 });
+			else if (nx == chunkSize)
+				ch->getRow(sy + y, sz + z, out);
+			else
+				*out = ch->get(sx, sy + y, sz + z);
+		}
+}
+
+void expandChunk(ChunkNeighbourhood const &chunks, expandedChunk &ex) {
+	for (int dz = -1; dz < 2; ++dz)
+		for (int dy = -1; dy < 2; ++dy)
+			for (int dx = -1; dx < 2; ++dx)
+				copyNeighbour(chunks[neighbourIndex(dx, dy, dz)], dx, dy, dz, ex);
+}
+
+MeshSnapshot *takeSnapshot(ChunkNeighbourhood const &chunks, MeshSegments const &segments) {
+	auto *s = meshSnapshotPool.create();
+	s->segments = segments;
+	for (int i = 0; i < neighbourhoodSize; ++i)
+		s->blocks[i] = chunks[i] ? chunks[i]->share() : ChunkBlocks {};
+	return s;
+}
+
+void expandSnapshot(MeshSnapshot const &s, expandedChunk &ex) {
+	ChunkNeighbourhood chunks;
+	for (int i = 0; i < neighbourhoodSize; ++i)
+		chunks[i] = &s.blocks[i];
+	expandChunk(chunks, ex);
+}
+
+void releaseSnapshot(MeshSnapshot *s) {
+	for (auto &b: s->blocks)
+		b.release();
+	meshSnapshotPool.destroy(s);
+}
 
 void freeMesh(MesherAllocation &alloc) {
 	if (alloc.vertices)
@@ -414,44 +556,92 @@ BlockVisual getBlockVisual(Block block) {
 	return {};
 }
 
-u8 getSidesOpaque(expandedChunk const &ch) {
-	u8 result = 0x3f;
-	 
-	for (int v = 0; v < chunkSize; ++v)
-		for (int u = 0; u < chunkSize; ++u) {
-			if (ch[v+1][u+1][1].isNonSolid())
-				result &= 0b11'11'10;
-			if (ch[v+1][u+1][chunkSize].isNonSolid())
-				result &= 0b11'11'01;
-			if (ch[v+1][1][u+1].isNonSolid())
-				result &= 0b11'10'11;
-			if (ch[v+1][chunkSize][u+1].isNonSolid())
-				result &= 0b11'01'11;
-			if (ch[1][v+1][u+1].isNonSolid())
-				result &= 0b10'11'11;
-			if (ch[chunkSize][v+1][u+1].isNonSolid())
-				result &= 0b01'11'11;
+// non-solid blocks, x + y * chunkSize + z * chunkSize^2
+using OpenBlocks = std::bitset<chunkVolume>;
+
+// faces of the chunk the block lies on
+INLINE u8 blockFaces(int x, int y, int z) {
+	return (x == 0) | (x == chunkMask) << 1 | (y == 0) << 2 | (y == chunkMask) << 3
+		| (z == 0) << 4 | (z == chunkMask) << 5;
+}
+
+// flood fills each pocket of open blocks that reaches a face, joining all the
+// faces it reaches; pockets inside the chunk cannot connect anything. eats open
+u16 floodConnectivity(OpenBlocks &open) {
+
+	// too large for the worker stack
+	thread_local std::array<u16, chunkVolume> stack;
+
+	u16 result = 0;
+
+	for (int start = 0; start < chunkVolume; ++start) {
+
+		if (!open[start])
+			continue;
+		int sx = start & chunkMask, sy = start >> chunkBits & chunkMask, sz = start >> (chunkBits * 2);
+		if (!blockFaces(sx, sy, sz))
+			continue;
+
+		open[start] = false;
+		stack[0] = start;
+		int size = 1;
+		u8 faces = 0;
+
+		while (size) {
+			int i = stack[--size];
+			int x = i & chunkMask, y = i >> chunkBits & chunkMask, z = i >> (chunkBits * 2);
+			faces |= blockFaces(x, y, z);
+
+			auto visit = [&](bool inside, int n) {
+				if (inside && open[n]) {
+					open[n] = false;
+					stack[size++] = n;
+				}
+			};
+			visit(x > 0, i - 1);
+			visit(x < chunkMask, i + 1);
+			visit(y > 0, i - chunkSize);
+			visit(y < chunkMask, i + chunkSize);
+			visit(z > 0, i - chunkSize * chunkSize);
+			visit(z < chunkMask, i + chunkSize * chunkSize);
 		}
+
+		for (int a = 0; a < chunkFaces; ++a)
+			for (int b = a + 1; b < chunkFaces; ++b)
+				if ((faces >> a & 1) && (faces >> b & 1))
+					result |= 1 << facePairBit(a, b);
+
+		if (result == allFacesConnected)
+			break;
+	}
+
 	return result;
 }
 
-u8 getSidesOpaque(chunk const &ch) {
-	u8 result = 0x3f;
-	 
-	for (int v = 0; v < chunkSize; ++v)
-		for (int u = 0; u < chunkSize; ++u) {
-			if (ch[v][u][0].isNonSolid())
-				result &= 0b11'11'10;
-			if (ch[v][u][chunkSize-1].isNonSolid())
-				result &= 0b11'11'01;
-			if (ch[v][0][u].isNonSolid())
-				result &= 0b11'10'11;
-			if (ch[v][chunkSize-1][u].isNonSolid())
-				result &= 0b11'01'11;
-			if (ch[0][v][u].isNonSolid())
-				result &= 0b10'11'11;
-			if (ch[chunkSize-1][v][u].isNonSolid())
-				result &= 0b01'11'11;
+u16 getConnectivity(expandedChunk const &ch) {
+
+	OpenBlocks open;
+	for (int z = 0; z < chunkSize; ++z)
+		for (int y = 0; y < chunkSize; ++y)
+			for (int x = 0; x < chunkSize; ++x)
+				open[x + (y << chunkBits) + (z << (chunkBits * 2))] = ch[z+1][y+1][x+1].isNonSolid();
+
+	return floodConnectivity(open);
+}
+
+u16 getConnectivity(ChunkBlocks const &blocks) {
+
+	if (blocks.isUniform())
+		return blocks.fill.isSolid() ? 0 : allFacesConnected;
+
+	OpenBlocks open;
+	std::array<Block, chunkSize> row;
+	for (int z = 0; z < chunkSize; ++z)
+		for (int y = 0; y < chunkSize; ++y) {
+			blocks.getRow(y, z, row.data());
+			for (int x = 0; x < chunkSize; ++x)
+				open[x + (y << chunkBits) + (z << (chunkBits * 2))] = row[x].isNonSolid();
 		}
-	return result;
+
+	return floodConnectivity(open);
 }
\ No newline at end of file
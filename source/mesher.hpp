@@ -1,8 +1,15 @@
 #pragma once
 
 #include "common.hpp"
+#include <bitset>
 #include <span>
 
+// meshes are laid out in segments: each layer of each of the six face directions,
+// then each z layer of foliage. a segment only depends on its own layer of blocks
+// and the one in front, so an edit only needs the segments next to it rebuilt
+constexpr int meshSegments = 6 * chunkSize + chunkSize;
+using MeshSegments = std::bitset<meshSegments>;
+
 struct MesherAllocation {
     /* FLAGS
 
@@ -24,17 +31,80 @@ struct MesherAllocation {
 	void *indices = nullptr;
 	u16 vertexCount = 0;
     std::vector<Mesh> meshes;
+
+	// first vertex of every segment, indices of a texture run through them in order
+	std::array<u16, meshSegments + 1> segmentVertices {};
+	MeshSegments segments; // segments meshed, all of them unless this is a patch
 };
 
 using expandedChunk = std::array<std::array<std::array<Block, chunkSize+2>, chunkSize+2>, chunkSize+2>;
 
-MesherAllocation meshChunk(expandedChunk const &ch);
-MesherAllocation meshChunk(chunk const &ch, std::array<chunk *, 6> const &sides);
-void expandChunk(chunk const &ch, std::array<chunk *, 6> const &sides, expandedChunk &ex);
+// a chunk with all 26 neighbours, the ones it shares a face, edge or corner with;
+// flattened [z + 1][y + 1][x + 1] offsets, the chunk itself in the middle
+constexpr int neighbourhoodSize = 27;
+
+INLINE constexpr int neighbourIndex(int dx, int dy, int dz) {
+	return (dz + 1) * 9 + (dy + 1) * 3 + dx + 1;
+}
+
+// null is air, as past the top and bottom of the world
+using ChunkNeighbourhood = std::array<ChunkBlocks const *, neighbourhoodSize>;
+
+// what a mesh task reads: shared references to the neighbourhood,
+// taken on the main thread and expanded by the worker
+struct MeshSnapshot {
+	std::array<ChunkBlocks, neighbourhoodSize> blocks;
+	MeshSegments segments; // the ones to mesh
+};
+
+// buffers handed between the main thread and the worker for each mesh task
+inline Pool<MeshSnapshot, 16> meshSnapshotPool;
+inline Pool<MesherAllocation, 16> meshAllocationPool;
+
+// only the given segments, the rest are left empty
+MesherAllocation meshChunk(expandedChunk const &ch, MeshSegments const &segments = MeshSegments().set());
+MesherAllocation meshChunk(ChunkNeighbourhood const &chunks);
+
+// changed blocks as one bit per layer along each axis, bit 0 for the layer
+// below the chunk and chunkSize + 1 for the one above; see ChunkMetadata::dirty
+MeshSegments dirtySegments(std::array<u32, 3> const &dirtyLayers);
+
+// counts without buffers: linear memory ran out while meshing, nothing can be drawn
+// from it or spliced into it, so the chunk has to be meshed whole again
+INLINE bool meshLost(MesherAllocation const &m) {
+	return !m.vertices && (m.vertexCount || m.segmentVertices[meshSegments]);
+}
+
+// the segments of patch put in place of the ones in base; both stay as they are and
+// neither may be lost. the result is lost if its own allocation fails
+MesherAllocation spliceMesh(MesherAllocation const &base, MesherAllocation const &patch);
+// fills all of ex, edges and corners included, so ambient occlusion is right at the borders
+void expandChunk(ChunkNeighbourhood const &chunks, expandedChunk &ex);
+
+MeshSnapshot *takeSnapshot(ChunkNeighbourhood const &chunks, MeshSegments const &segments);
+void expandSnapshot(MeshSnapshot const &s, expandedChunk &ex);
+// drops the references and gives the snapshot back to the pool
+void releaseSnapshot(MeshSnapshot *s);
 
 void freeMesh(MesherAllocation &);
 
 BlockVisual getBlockVisual(Block block);
 
-u8 getSidesOpaque(expandedChunk const &ch);
-u8 getSidesOpaque(chunk const &ch);
\ No newline at end of file
+// chunk faces -x, +x, -y, +y, -z, +z; the opposite of face f is f ^ 1
+constexpr int chunkFaces = 6;
+
+// which of the 15 pairs of faces are joined through the chunk's non-solid blocks,
+// a bit per pair; what lets the renderer skip chunks that cannot be seen
+constexpr u16 allFacesConnected = 0x7fff;
+
+INLINE constexpr int facePairBit(int a, int b) {
+	int lo = std::min(a, b), hi = std::max(a, b);
+	return lo * (11 - lo) / 2 + hi - lo - 1;
+}
+
+INLINE constexpr bool facesConnected(u16 connectivity, int a, int b) {
+	return connectivity >> facePairBit(a, b) & 1;
+}
+
+u16 getConnectivity(expandedChunk const &ch);
+u16 getConnectivity(ChunkBlocks const &ch);
\ No newline at end of file
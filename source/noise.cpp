@@ -10,3 +10,328 @@ float noise3d(int seed, float x, float y, float z) {
 float noise2d(int seed, float x, float y) {
     return _fnlSingleSimplex2D(seed, x, y);
 }
+
+#if defined(__SSE2__)
+
+// host builds: the same math as FastNoiseLite, one lane per point;
+// branches become selects so every lane runs the exact scalar op sequence
+
+namespace {
+
+#if defined(__AVX__)
+constexpr int lanes = 8;
+#else
+constexpr int lanes = 4;
+#endif
+
+using vfloat = float __attribute__((vector_size(lanes * 4)));
+using vint = int __attribute__((vector_size(lanes * 4)));
+
+inline vfloat toFloat(vint v) { return __builtin_convertvector(v, vfloat); }
+inline vint toInt(vfloat v) { return __builtin_convertvector(v, vint); }
+
+inline vfloat load(float const *p) { vfloat v; __builtin_memcpy(&v, p, sizeof(v)); return v; }
+inline void store(float *p, vfloat v) { __builtin_memcpy(p, &v, sizeof(v)); }
+
+inline vint fastFloor(vfloat f) { vint t = toInt(f); return f >= 0 ? t : t - 1; }
+inline vint fastRound(vfloat f) { return f >= 0 ? toInt(f + 0.5f) : toInt(f - 0.5f); }
+
+// hashing is lane-parallel, only the gradient table lookup is scalar
+inline vfloat gradCoord2D(int seed, vint xPrimed, vint yPrimed, vfloat xd, vfloat yd) {
+    vint hash = (seed ^ xPrimed ^ yPrimed) * 0x27d4eb2d;
+    hash ^= hash >> 15;
+    hash &= 127 << 1;
+    vfloat gx, gy;
+    for (int l = 0; l < lanes; ++l) {
+        gx[l] = GRADIENTS_2D[hash[l]];
+        gy[l] = GRADIENTS_2D[hash[l] | 1];
+    }
+    return xd * gx + yd * gy;
+}
+
+inline vfloat gradCoord3D(int seed, vint xPrimed, vint yPrimed, vint zPrimed, vfloat xd, vfloat yd, vfloat zd) {
+    vint hash = (seed ^ xPrimed ^ yPrimed ^ zPrimed) * 0x27d4eb2d;
+    hash ^= hash >> 15;
+    hash &= 63 << 2;
+    vfloat gx, gy, gz;
+    for (int l = 0; l < lanes; ++l) {
+        gx[l] = GRADIENTS_3D[hash[l]];
+        gy[l] = GRADIENTS_3D[hash[l] | 1];
+        gz[l] = GRADIENTS_3D[hash[l] | 2];
+    }
+    return xd * gx + yd * gy + zd * gz;
+}
+
+// mirrors _fnlSingleSimplex2D
+vfloat simplex2D(int seed, vfloat x, vfloat y) {
+
+    const float SQRT3 = 1.7320508075688772935274463415059f;
+    const float G2 = (3 - SQRT3) / 6;
+
+    vint i = fastFloor(x);
+    vint j = fastFloor(y);
+    vfloat xi = x - toFloat(i);
+    vfloat yi = y - toFloat(j);
+
+    vfloat t = (xi + yi) * G2;
+    vfloat x0 = xi - t;
+    vfloat y0 = yi - t;
+
+    i *= PRIME_X;
+    j *= PRIME_Y;
+
+    vfloat zero = {};
+
+    vfloat a = 0.5f - x0 * x0 - y0 * y0;
+    vfloat n0 = a <= 0 ? zero : (a * a) * (a * a) * gradCoord2D(seed, i, j, x0, y0);
+
+    vfloat c = (float)(2 * (1 - 2 * G2) * (1 / G2 - 2)) * t + ((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2)) + a);
+    vfloat x2 = x0 + (2 * (float)G2 - 1);
+    vfloat y2 = y0 + (2 * (float)G2 - 1);
+    vfloat n2 = c <= 0 ? zero : (c * c) * (c * c) * gradCoord2D(seed, i + PRIME_X, j + PRIME_Y, x2, y2);
+
+    auto upper = y0 > x0;
+    vfloat x1 = upper ? x0 + (float)G2 : x0 + ((float)G2 - 1);
+    vfloat y1 = upper ? y0 + ((float)G2 - 1) : y0 + (float)G2;
+    vint i1 = upper ? i : i + PRIME_X;
+    vint j1 = upper ? j + PRIME_Y : j;
+    vfloat b = 0.5f - x1 * x1 - y1 * y1;
+    vfloat n1 = b <= 0 ? zero : (b * b) * (b * b) * gradCoord2D(seed, i1, j1, x1, y1);
+
+    return (n0 + n1 + n2) * 99.83685446303647f;
+}
+
+// mirrors _fnlSingleOpenSimplex23D
+vfloat openSimplex23D(int seed, vfloat x, vfloat y, vfloat z) {
+
+    vint i = fastRound(x);
+    vint j = fastRound(y);
+    vint k = fastRound(z);
+    vfloat x0 = x - toFloat(i);
+    vfloat y0 = y - toFloat(j);
+    vfloat z0 = z - toFloat(k);
+
+    vint xNSign = toInt(-1.0f - x0) | 1;
+    vint yNSign = toInt(-1.0f - y0) | 1;
+    vint zNSign = toInt(-1.0f - z0) | 1;
+
+    vfloat ax0 = toFloat(xNSign) * -x0;
+    vfloat ay0 = toFloat(yNSign) * -y0;
+    vfloat az0 = toFloat(zNSign) * -z0;
+
+    i *= PRIME_X;
+    j *= PRIME_Y;
+    k *= PRIME_Z;
+
+    vfloat zero = {};
+    vfloat value = zero;
+    vfloat a = (0.6f - x0 * x0) - (y0 * y0 + z0 * z0);
+
+    for (int l = 0; ; l++) {
+
+        value += a > 0 ? (a * a) * (a * a) * gradCoord3D(seed, i, j, k, x0, y0, z0) : zero;
+
+        vfloat b = a + 1;
+
+        auto alongX = (ax0 >= ay0) & (ax0 >= az0);
+        auto alongY = ~alongX & (ay0 > ax0) & (ay0 >= az0);
+        auto alongZ = ~alongX & ~alongY;
+
+        vfloat x1 = alongX ? x0 + toFloat(xNSign) : x0;
+        vfloat y1 = alongY ? y0 + toFloat(yNSign) : y0;
+        vfloat z1 = alongZ ? z0 + toFloat(zNSign) : z0;
+
+        b = alongX ? b - toFloat(xNSign * 2) * x1 : b;
+        b = alongY ? b - toFloat(yNSign * 2) * y1 : b;
+        b = alongZ ? b - toFloat(zNSign * 2) * z1 : b;
+
+        vint i1 = alongX ? i - xNSign * PRIME_X : i;
+        vint j1 = alongY ? j - yNSign * PRIME_Y : j;
+        vint k1 = alongZ ? k - zNSign * PRIME_Z : k;
+
+        value += b > 0 ? (b * b) * (b * b) * gradCoord3D(seed, i1, j1, k1, x1, y1, z1) : zero;
+
+        if (l == 1)
+            break;
+
+        ax0 = 0.5f - ax0;
+        ay0 = 0.5f - ay0;
+        az0 = 0.5f - az0;
+
+        x0 = toFloat(xNSign) * ax0;
+        y0 = toFloat(yNSign) * ay0;
+        z0 = toFloat(zNSign) * az0;
+
+        a += (0.75f - ax0) - (ay0 + az0);
+
+        i += (xNSign >> 1) & PRIME_X;
+        j += (yNSign >> 1) & PRIME_Y;
+        k += (zNSign >> 1) & PRIME_Z;
+
+        xNSign = -xNSign;
+        yNSign = -yNSign;
+        zNSign = -zNSign;
+
+        seed = ~seed;
+    }
+
+    return value * 32.69428253173828125f;
+}
+
+}
+
+void noise2dBatch(int seed, float const *x, float const *y, float *out, int count) {
+    int n = 0;
+    for (; n + lanes <= count; n += lanes)
+        store(out + n, simplex2D(seed, load(x + n), load(y + n)));
+    for (; n < count; ++n)
+        out[n] = noise2d(seed, x[n], y[n]);
+}
+
+void noise3dBatch(int seed, float const *x, float const *y, float const *z, float *out, int count) {
+    int n = 0;
+    for (; n + lanes <= count; n += lanes)
+        store(out + n, openSimplex23D(seed, load(x + n), load(y + n), load(z + n)));
+    for (; n < count; ++n)
+        out[n] = noise3d(seed, x[n], y[n], z[n]);
+}
+
+#else
+
+// no simd on the 3ds; keep the batch interface as a plain loop
+
+void noise2dBatch(int seed, float const *x, float const *y, float *out, int count) {
+    for (int n = 0; n < count; ++n)
+        out[n] = noise2d(seed, x[n], y[n]);
+}
+
+void noise3dBatch(int seed, float const *x, float const *y, float const *z, float *out, int count) {
+    for (int n = 0; n < count; ++n)
+        out[n] = noise3d(seed, x[n], y[n], z[n]);
+}
+
+#endif
+
+#ifdef FIXED_NOISE
+
+#include "dcsimplex.hpp"
+
+namespace {
+
+using dcs::FIXED_BITS;
+using dcs::FIXED_ONE;
+using dcs::toFixed;
+using dcs::fmul;
+
+const auto gradients2DFixed = [] {
+    std::array<int32_t, sizeof(GRADIENTS_2D) / sizeof(float)> table;
+    for (size_t i = 0; i < table.size(); ++i)
+        table[i] = toFixed(GRADIENTS_2D[i]);
+    return table;
+}();
+
+inline int32_t gradCoord2DFixed(int seed, int xPrimed, int yPrimed, int32_t xd, int32_t yd) {
+    int hash = _fnlHash2D(seed, xPrimed, yPrimed);
+    hash ^= hash >> 15;
+    hash &= 127 << 1;
+    return fmul(xd, gradients2DFixed[hash]) + fmul(yd, gradients2DFixed[hash | 1]);
+}
+
+inline int32_t pow4(int32_t a) {
+    int32_t sq = fmul(a, a);
+    return fmul(sq, sq);
+}
+
+// q20 port of _fnlSingleSimplex2D at (xb + xf, yb + yf)
+int32_t simplex2DFixed(int seed, int xb, int32_t xf, int yb, int32_t yf) {
+
+    constexpr float SQRT3 = 1.7320508075688772935274463415059f;
+    constexpr float G2 = (3 - SQRT3) / 6;
+
+    constexpr int32_t G2F = toFixed(G2);
+    constexpr int32_t G2M1 = toFixed((float)G2 - 1);
+    constexpr int32_t G2X2M1 = toFixed(2 * (float)G2 - 1);
+    constexpr int32_t C1 = toFixed((float)(2 * (1 - 2 * G2) * (1 / G2 - 2)));
+    constexpr int32_t C2 = toFixed((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2)));
+    constexpr int32_t HALF = FIXED_ONE / 2;
+    constexpr int32_t NORM = toFixed(99.83685446303647f);
+
+    int i = xb + (xf >> FIXED_BITS);
+    int j = yb + (yf >> FIXED_BITS);
+    int32_t xi = xf & (FIXED_ONE - 1);
+    int32_t yi = yf & (FIXED_ONE - 1);
+
+    int32_t t = fmul(xi + yi, G2F);
+    int32_t x0 = xi - t;
+    int32_t y0 = yi - t;
+
+    i *= PRIME_X;
+    j *= PRIME_Y;
+
+    int32_t n0 = 0, n1 = 0, n2 = 0;
+
+    int32_t a = HALF - fmul(x0, x0) - fmul(y0, y0);
+    if (a > 0)
+        n0 = fmul(pow4(a), gradCoord2DFixed(seed, i, j, x0, y0));
+
+    int32_t c = fmul(C1, t) + (C2 + a);
+    if (c > 0)
+        n2 = fmul(pow4(c), gradCoord2DFixed(seed, i + PRIME_X, j + PRIME_Y, x0 + G2X2M1, y0 + G2X2M1));
+
+    if (y0 > x0) {
+        int32_t x1 = x0 + G2F;
+        int32_t y1 = y0 + G2M1;
+        int32_t b = HALF - fmul(x1, x1) - fmul(y1, y1);
+        if (b > 0)
+            n1 = fmul(pow4(b), gradCoord2DFixed(seed, i, j + PRIME_Y, x1, y1));
+    } else {
+        int32_t x1 = x0 + G2M1;
+        int32_t y1 = y0 + G2F;
+        int32_t b = HALF - fmul(x1, x1) - fmul(y1, y1);
+        if (b > 0)
+            n1 = fmul(pow4(b), gradCoord2DFixed(seed, i + PRIME_X, j, x1, y1));
+    }
+
+    return fmul(n0 + n1 + n2, NORM);
+}
+
+}
+
+// the grid origin is split once in float, steps across the grid stay in q20
+void noise2dGrid(int seed, int x0, int y0, float scale, float *out) {
+    float ox = x0 * scale, oy = y0 * scale;
+    int xb = _fnlFastFloor(ox), yb = _fnlFastFloor(oy);
+    int32_t xf = (int32_t)((ox - xb) * FIXED_ONE);
+    int32_t yf = (int32_t)((oy - yb) * FIXED_ONE);
+    int32_t step = toFixed(scale);
+
+    for (int j = 0; j < noiseGridSize; ++j)
+        for (int i = 0; i < noiseGridSize; ++i)
+            out[i + j * noiseGridSize] =
+                simplex2DFixed(seed, xb, xf + i * step, yb, yf + j * step) * (1.0f / FIXED_ONE);
+}
+
+#else
+
+void noise2dGrid(int seed, int x0, int y0, float scale, float *out) {
+    float xs[noiseGridSize * noiseGridSize];
+    float ys[noiseGridSize * noiseGridSize];
+    for (int j = 0; j < noiseGridSize; ++j)
+        for (int i = 0; i < noiseGridSize; ++i) {
+            xs[i + j * noiseGridSize] = (x0 + i) * scale;
+            ys[i + j * noiseGridSize] = (y0 + j) * scale;
+        }
+    noise2dBatch(seed, xs, ys, out, noiseGridSize * noiseGridSize);
+}
+
+#endif
+
+void noise3dRun(int seed, int x, int y, int z0, float scale, float *out, int count) {
+    float xs[noiseGridSize], ys[noiseGridSize], zs[noiseGridSize];
+    for (int k = 0; k < count; ++k) {
+        xs[k] = x * scale;
+        ys[k] = y * scale;
+        zs[k] = (z0 + k) * scale;
+    }
+    noise3dBatch(seed, xs, ys, zs, out, count);
+}
@@ -1,4 +1,23 @@
 #pragma once
 
+// integer-only heightmap and tunnel noise for the old 3ds worker core;
+// terrain matches the float kernels to within a fraction of a block
+// #define FIXED_NOISE
+
 float noise2d(int seed, float x, float y);
 float noise3d(int seed, float x, float y, float z);
+
+// batched evaluation over structure-of-arrays input; vectorised on hosts with SSE/AVX,
+// a plain loop on the 3ds. results match the single-point functions bit for bit,
+// unless the compiler is allowed to fuse multiply-adds (-mfma without -ffp-contract=off),
+// in which case they differ by up to ~2e-7
+void noise2dBatch(int seed, float const *x, float const *y, float *out, int count);
+void noise3dBatch(int seed, float const *x, float const *y, float const *z, float *out, int count);
+
+constexpr int noiseGridSize = 16;
+
+// full column grid at block coordinates (x0 + i, y0 + j) * scale, stored as out[i + j * 16]
+void noise2dGrid(int seed, int x0, int y0, float scale, float *out);
+
+// vertical run at block coordinates (x, y, z0 + k) * scale, for k < count <= 16
+void noise3dRun(int seed, int x, int y, int z0, float scale, float *out, int count);
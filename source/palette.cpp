@@ -0,0 +1,126 @@
+#include "common.hpp"
+
+namespace {
+
+INLINE int wordCount(int logBits) {
+	return (chunkVolume << logBits) / 32;
+}
+
+INLINE void setIndex(PalettedChunk &p, int i, int value) {
+	int shift = 5 - p.logBits;
+	int bit = (i & ((1 << shift) - 1)) << p.logBits;
+	u32 mask = ((1u << p.bits()) - 1) << bit;
+	u32 &w = p.words()[i >> shift];
+	w = (w & ~mask) | ((u32)value << bit);
+}
+
+}
+
+PalettedChunk *PalettedChunk::create(int logBits) {
+	size_t size = sizeof(PalettedChunk) + (sizeof(Block) << (1 << logBits)) + wordCount(logBits) * sizeof(u32);
+	auto *p = new (new u32[size / sizeof(u32)]()) PalettedChunk;
+	p->logBits = logBits;
+	p->count = 0;
+	p->refs = 1;
+	return p;
+}
+
+PalettedChunk *PalettedChunk::clone(PalettedChunk const &p) {
+	auto *c = create(p.logBits);
+	c->count = p.count;
+	std::copy(p.palette(), p.palette() + p.count, c->palette());
+	std::copy(p.words(), p.words() + wordCount(p.logBits), c->words());
+	return c;
+}
+
+void PalettedChunk::release(PalettedChunk *p) {
+	if (!p || --p->refs)
+		return;
+	p->~PalettedChunk();
+	delete[] reinterpret_cast<u32 *>(p);
+}
+
+size_t PalettedChunk::bytes() const {
+	return sizeof(PalettedChunk) + (sizeof(Block) << bits()) + wordCount(logBits) * sizeof(u32);
+}
+
+void PalettedChunk::getRow(int i, Block *out) const {
+	// bit offsets run on across the words of the row, no per-block division
+	u32 const *w = words();
+	u32 mask = (1u << bits()) - 1;
+	auto *pal = palette();
+	for (int x = 0, bit = i << logBits; x < chunkSize; ++x, bit += bits())
+		out[x] = pal[(w[bit >> 5] >> (bit & 31)) & mask];
+}
+
+bool PalettedChunk::set(int i, Block block) {
+	auto *pal = palette();
+	int n = 0;
+	while (n < count && pal[n].value != block.value)
+		++n;
+	if (n == count) {
+		if (count == (1 << bits()))
+			return false;
+		pal[count++] = block;
+	}
+	setIndex(*this, i, n);
+	return true;
+}
+
+PalettedChunk *PalettedChunk::pack(chunk const &data) {
+
+	Block const *blocks = &data[0][0][0];
+
+	// distinct values first, to pick the width
+	std::array<Block, 256> pal;
+	int count = 0;
+	for (int i = 0; i < chunkVolume; ++i) {
+		// runs are common, skip the palette search for them
+		if (i && blocks[i].value == blocks[i - 1].value)
+			continue;
+		int n = 0;
+		while (n < count && pal[n].value != blocks[i].value)
+			++n;
+		if (n == count) {
+			if (count == 256)
+				return nullptr;
+			pal[count++] = blocks[i];
+		}
+	}
+
+	int logBits = 0;
+	while ((1 << (1 << logBits)) < count)
+		++logBits;
+
+	auto *p = create(logBits);
+	std::copy(pal.begin(), pal.begin() + count, p->palette());
+	p->count = count;
+
+	int last = 0;
+	for (int i = 0; i < chunkVolume; ++i) {
+		if (p->palette()[last].value != blocks[i].value) {
+			last = 0;
+			while (p->palette()[last].value != blocks[i].value)
+				++last;
+		}
+		setIndex(*p, i, last);
+	}
+	return p;
+}
+
+PalettedChunk *PalettedChunk::widen(PalettedChunk const &p) {
+	if (p.logBits == 3)
+		return nullptr;
+	auto *w = create(p.logBits + 1);
+	std::copy(p.palette(), p.palette() + p.count, w->palette());
+	w->count = p.count;
+	for (int i = 0; i < chunkVolume; ++i)
+		setIndex(*w, i, p.index(i));
+	return w;
+}
+
+void PalettedChunk::unpack(chunk &out) const {
+	for (int z = 0; z < chunkSize; ++z)
+		for (int y = 0; y < chunkSize; ++y)
+			getRow((y << chunkBits) + (z << (chunkBits * 2)), out[z][y].data());
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#ifdef __3DS__
+#include <3ds.h>
+#else
+#include "host.hpp"
+#endif
+
+#include <new>
+#include <vector>
+
+struct PoolStats {
+	u32 allocations = 0; // total, including ones served from the free list
+	u32 live = 0;
+	u32 highWater = 0; // most live at once
+	u32 slabs = 0;
+	u32 capacity = 0; // objects the slabs hold
+};
+
+// fixed-size objects carved out of slabs that are never given back, so buffers streamed
+// in and out every frame do not churn or fragment the heap. free slots form a list
+// threaded through their storage; a lock lets one thread allocate and another free
+template <typename T, int SlabObjects>
+struct Pool {
+
+	Pool() { LightLock_Init(&lock); }
+	Pool(Pool const &) = delete;
+	~Pool() {
+		for (auto *s: slabs)
+			delete[] s;
+	}
+
+	// default initialised, so plain arrays like chunk come back with old contents
+	T *create() { return new (take()) T; }
+	// value initialised, zeroed for plain arrays
+	T *createZeroed() { return new (take()) T(); }
+
+	void destroy(T *object) {
+		if (!object)
+			return;
+		object->~T();
+		auto *n = reinterpret_cast<Node *>(object);
+		LightLock_Lock(&lock);
+		n->next = free;
+		free = n;
+		--stats.live;
+		LightLock_Unlock(&lock);
+	}
+
+	PoolStats getStats() {
+		LightLock_Lock(&lock);
+		auto s = stats;
+		LightLock_Unlock(&lock);
+		return s;
+	}
+
+private:
+	union Node {
+		Node *next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	LightLock lock;
+	Node *free = nullptr;
+	std::vector<Node *> slabs;
+	PoolStats stats;
+
+	void *take() {
+		LightLock_Lock(&lock);
+		if (!free) {
+			auto *slab = new Node[SlabObjects];
+			slabs.push_back(slab);
+			for (int i = SlabObjects - 1; i >= 0; --i) {
+				slab[i].next = free;
+				free = &slab[i];
+			}
+			++stats.slabs;
+			stats.capacity += SlabObjects;
+		}
+		auto *n = free;
+		free = n->next;
+		++stats.allocations;
+		if (++stats.live > stats.highWater)
+			stats.highWater = stats.live;
+		LightLock_Unlock(&lock);
+		return n->storage;
+	}
+};
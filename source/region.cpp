@@ -0,0 +1,205 @@
+#include "region.hpp"
+
+#include <cstdio>
+
+using namespace region;
+
+namespace {
+
+#ifdef FIXED_NOISE
+constexpr u16 buildFlags = flagFixedNoise;
+#else
+constexpr u16 buildFlags = 0;
+#endif
+
+struct {
+	FILE *file = nullptr;
+	long size = 0;
+	Header header;
+	std::vector<Entry> index;
+	// read buffer, too large for the worker stack
+	std::array<u16, chunkVolume * 2> runs;
+	LightLock lock;
+} loaded;
+
+Entry const *find(s16 cx, s16 cy, s16 cz) {
+	auto &h = loaded.header;
+	int x = cx - h.x0, y = cy - h.y0, z = cz + zChunks;
+	if (x < 0 || y < 0 || x >= h.side || y >= h.side || z < 0 || z >= columnChunks)
+		return nullptr;
+	return &loaded.index[((y * h.side) + x) * columnChunks + z];
+}
+
+// (length, block) pairs into a newly allocated chunk
+chunk *expandRuns(u16 const *runs, int count) {
+
+	auto *dense = createChunk();
+	Block *b = &(*dense)[0][0][0];
+	int i = 0;
+	for (int r = 0; r < count; ++r)
+		for (int n = runs[r * 2]; n > 0 && i < chunkVolume; --n)
+			b[i++] = { runs[r * 2 + 1] };
+
+	if (i != chunkVolume) {
+		releaseChunk(dense);
+		return nullptr;
+	}
+	return dense;
+}
+
+// the lock is held by the caller
+bool read(Entry const &e, ChunkBlocks &out) {
+
+	out.fill = { e.fill };
+	out.dense = nullptr;
+	if (!e.runs)
+		return true;
+
+	// a damaged entry must not run past the buffer or the file
+	if (e.runs > chunkVolume || e.offset + e.runs * sizeof(u16) * 2 > (size_t)loaded.size)
+		return false;
+
+	if (fseek(loaded.file, e.offset, SEEK_SET) ||
+		fread(loaded.runs.data(), sizeof(u16) * 2, e.runs, loaded.file) != e.runs)
+		return false;
+
+	out.dense = expandRuns(loaded.runs.data(), e.runs);
+	return out.dense != nullptr;
+}
+
+}
+
+EncodedChunk region::encode(ChunkBlocks const &blocks) {
+
+	EncodedChunk e { blocks.fill, {} };
+	if (blocks.isUniform())
+		return e;
+
+	// runs carry on across rows
+	std::array<Block, chunkSize> row;
+	for (int z = 0; z < chunkSize; ++z)
+		for (int y = 0; y < chunkSize; ++y) {
+			blocks.getRow(y, z, row.data());
+			for (auto b: row)
+				if (!e.runs.empty() && e.runs.back() == b.value)
+					++e.runs[e.runs.size() - 2];
+				else {
+					e.runs.push_back(1);
+					e.runs.push_back(b.value);
+				}
+		}
+
+	// a dense chunk that turned out to be a single block
+	if (e.runs.size() == 2) {
+		e.fill = { e.runs[1] };
+		e.runs.clear();
+	}
+	return e;
+}
+
+bool region::decode(EncodedChunk const &e, ChunkBlocks &out) {
+	out.fill = e.fill;
+	out.dense = nullptr;
+	if (e.runs.empty())
+		return true;
+	out.dense = expandRuns(e.runs.data(), e.runs.size() / 2);
+	return out.dense != nullptr;
+}
+
+bool region::write(char const *path, s16 x0, s16 y0, int side, std::vector<EncodedChunk> const &chunks) {
+
+	if ((int)chunks.size() != side * side * columnChunks)
+		return false;
+
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return false;
+
+	Header h { magic, version, buildFlags, x0, y0, (u16)side, (u16)zChunks, worldgen::getSettingsHash() };
+
+	std::vector<Entry> index;
+	index.reserve(chunks.size());
+	u32 offset = sizeof(Header) + sizeof(Entry) * chunks.size();
+	for (auto &c: chunks) {
+		u16 runs = c.runs.size() / 2;
+		index.push_back({ runs ? offset : 0, runs, c.fill.value });
+		offset += c.runs.size() * sizeof(u16);
+	}
+
+	bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+	ok = ok && fwrite(index.data(), sizeof(Entry), index.size(), f) == index.size();
+	for (auto &c: chunks)
+		ok = ok && fwrite(c.runs.data(), sizeof(u16), c.runs.size(), f) == c.runs.size();
+
+	return fclose(f) == 0 && ok;
+}
+
+bool region::open(char const *path) {
+
+	close();
+	LightLock_Init(&loaded.lock);
+
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	auto &h = loaded.header;
+	bool ok = fread(&h, sizeof(h), 1, f) == 1 &&
+		h.magic == magic && h.version == version &&
+		h.flags == buildFlags && h.zChunks == zChunks && h.settings == worldgen::getSettingsHash();
+
+	ok = ok && !fseek(f, 0, SEEK_END) && (loaded.size = ftell(f)) > 0 && !fseek(f, sizeof(h), SEEK_SET);
+
+	if (ok) {
+		loaded.index.resize(h.side * h.side * columnChunks);
+		ok = fread(loaded.index.data(), sizeof(Entry), loaded.index.size(), f) == loaded.index.size();
+	}
+
+	if (!ok) {
+		fclose(f);
+		loaded.index = {};
+		return false;
+	}
+
+	loaded.file = f;
+	return true;
+}
+
+void region::close() {
+	if (loaded.file)
+		fclose(loaded.file);
+	loaded.file = nullptr;
+	loaded.index = {};
+}
+
+bool region::loadChunk(s16 cx, s16 cy, s16 cz, ChunkBlocks &out) {
+
+	if (!loaded.file)
+		return false;
+	auto *e = find(cx, cy, cz);
+	if (!e)
+		return false;
+
+	LightLock_Lock(&loaded.lock);
+	bool ok = read(*e, out);
+	LightLock_Unlock(&loaded.lock);
+	return ok;
+}
+
+bool region::loadColumn(s16 cx, s16 cy, std::array<ChunkBlocks, columnChunks> &out) {
+
+	if (!loaded.file || !find(cx, cy, 0))
+		return false;
+
+	LightLock_Lock(&loaded.lock);
+	int i = 0;
+	while (i < columnChunks && read(*find(cx, cy, i - zChunks), out[i]))
+		++i;
+	LightLock_Unlock(&loaded.lock);
+
+	// a damaged file falls back to generating the whole column
+	if (i < columnChunks)
+		while (i--)
+			out[i].release();
+	return i == columnChunks;
+}
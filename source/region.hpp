@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common.hpp"
+#include "worldgen.hpp"
+
+#include <vector>
+
+// pregenerated square of columns, written on a desktop by tools/pregen;
+// chunks inside it are read back instead of generated on the worker
+namespace region {
+
+// file layout: header, one entry per chunk as [y][x][z], then the runs of dense chunks.
+// both the 3ds and the hosts we build on are little endian, so it is all written as is
+constexpr u32 magic = 'c' | 'r' << 8 | 'g' << 16 | 'n' << 24;
+constexpr u16 version = 2;
+constexpr u16 flagFixedNoise = 1; // generated with FIXED_NOISE, only valid for such builds
+
+struct Header {
+	u32 magic;
+	u16 version;
+	u16 flags;
+	s16 x0, y0; // lowest column
+	u16 side; // columns along x and y
+	u16 zChunks;
+	u32 settings; // worldgen::getSettingsHash when written
+};
+
+struct Entry {
+	u32 offset; // of the runs, from the start of the file
+	u16 runs; // 0 for uniform chunks
+	u16 fill;
+};
+
+// dense chunk as (length, block) pairs in [z][y][x] order; uniform ones only keep the fill
+struct EncodedChunk {
+	Block fill { 0 };
+	std::vector<u16> runs;
+};
+
+EncodedChunk encode(ChunkBlocks const &blocks);
+// false if the runs do not add up to a chunk
+bool decode(EncodedChunk const &e, ChunkBlocks &out);
+
+// chunks as [y][x][z], with side * side * columnChunks of them
+bool write(char const *path, s16 x0, s16 y0, int side, std::vector<EncodedChunk> const &chunks);
+
+// keeps the file open and its index in memory; false if missing, damaged, or made for
+// another build or other worldgen settings, so set those first
+bool open(char const *path);
+void close();
+
+// false outside the region, the caller generates the chunk then
+bool loadChunk(s16 cx, s16 cy, s16 cz, ChunkBlocks &out);
+bool loadColumn(s16 cx, s16 cy, std::array<ChunkBlocks, columnChunks> &out);
+
+}
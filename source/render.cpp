@@ -490,6 +490,10 @@ struct {
 
 	C3D_Mtx worldView, skyView;
 
+	// reachable from the camera, found once for both eyes; all chunks when not found
+	std::vector<WorldMap::Slot *> visibleChunks;
+	bool culled;
+
 } sceneSetup;
 
 void setupRender(fvec3 &playerPos, float rx, float ry, vec3<s32> *focus) {
@@ -523,6 +527,13 @@ void setupRender(fvec3 &playerPos, float rx, float ry, vec3<s32> *focus) {
 	sceneSetup.drawFocus = focus != nullptr;
 	if (focus)
 		sceneSetup.focus = *focus;
+
+	s16vec3 cameraChunk {
+		(s16)(fastFloor(sceneSetup.camera.x) >> chunkBits),
+		(s16)(fastFloor(sceneSetup.camera.y) >> chunkBits),
+		(s16)(fastFloor(sceneSetup.camera.z) >> chunkBits)
+	};
+	sceneSetup.culled = findVisibleChunks(cameraChunk, renderDistance, sceneSetup.visibleChunks);
 }
 
 void sceneRender(float iod) {
@@ -603,11 +614,13 @@ void sceneRender(float iod) {
 	/// --- DRAW BLOCKS --- ///
 
 	chunksDrawn = 0;
-	for (auto [idx, meta]: world) {
+	auto drawChunk = [&](WorldMap::Slot &slot) {
+		auto &idx = slot.idx;
+		auto &meta = slot.value;
 		int dx = idx.x-chX;
 		int dy = idx.y-chY;
 		int dz = idx.z-chZ;
-		// if (idx.x != 0 || idx.y != 0 || idx.z != 0) continue; // to the solitary mode
+		// if (idx.x != 0 || idx.y != 0 || idx.z != 0) return; // to the solitary mode
 		int distance2 = dx*dx+dy*dy+dz*dz;
 		 // todo do this check once for stereo rendering
 		if (
@@ -647,7 +660,16 @@ void sceneRender(float iod) {
 				offset += m.count;
 			}
 		}
-	}
+	};
+
+	// nearest first when culled, which also saves the gpu some overdraw
+	if (sceneSetup.culled)
+		for (auto *slot: sceneSetup.visibleChunks)
+			drawChunk(*slot);
+	else
+		for (auto &slot: world.slots)
+			if (slot.used)
+				drawChunk(slot);
 
 	/// --- DRAW FOCUS HIGHLIGHT --- ///
 
@@ -758,6 +780,9 @@ void render(fvec3 &playerPos, float rx, float ry, vec3<s32> *focus, float depthS
 			printf("Profile time : %4.1f%%    \n", custom + 0.1f);
 			printf("Profile calls: %3i    \n", (int)_customProfileCalls);
 			printf("Chunks drawn : %3i    \n", chunksDrawn);
+			printf("Chunks seen  : %3i    \n", sceneSetup.culled ? (int)sceneSetup.visibleChunks.size() : -1);
+			auto chunks = chunkPool.getStats();
+			printf("Chunk pool   : %4i / %4i    \n", (int)chunks.live, (int)chunks.highWater);
 		}
 	}
 	_customProfileCalls = 0;
@@ -0,0 +1,19 @@
+#include "rng.hpp"
+
+#include <array>
+
+void rng::column(u32 key, int x0, int y0, u16 *out) {
+
+	std::array<u32, chunkSize / 2> pairs;
+	for (int p = 0; p < chunkSize / 2; ++p)
+		pairs[p] = hashX(key, x0 + p * 2);
+
+	for (int j = 0; j < chunkSize; ++j) {
+		u32 row = hashY(key, y0 + j);
+		for (int p = 0; p < chunkSize / 2; ++p) {
+			u32 d = mix(pairs[p] ^ row);
+			out[p * 2 + j * chunkSize] = d;
+			out[p * 2 + 1 + j * chunkSize] = d >> 16;
+		}
+	}
+}
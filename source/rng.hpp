@@ -0,0 +1,46 @@
+#pragma once
+#include "common.hpp"
+
+// counter-based random numbers: a draw is a pure function of the key and the block
+// column, so every block draws its own numbers without walking a sequence, in any order
+// and on any thread. x and y are hashed on their own and one more hash joins them; that
+// last one is shared by two blocks along x, 16 bits each, so a chunk column takes 128
+// hashes plus one for each pair of blocks along x and each row
+
+namespace rng {
+
+// lowbias32 by chris wellons: a bijection where every input bit reaches every output bit
+constexpr u32 mix(u32 v) {
+	v ^= v >> 16;
+	v *= 0x7feb352d;
+	v ^= v >> 15;
+	v *= 0x846ca68b;
+	v ^= v >> 16;
+	return v;
+}
+
+// keeps the y hashes apart from the x ones; the line where they could meet is far
+// outside the world
+constexpr u32 ySalt = 0x9e3779b9;
+
+// the pair of blocks along x that x belongs to
+constexpr u32 hashX(u32 key, int x) {
+	return mix((x >> 1) ^ key);
+}
+
+constexpr u32 hashY(u32 key, int y) {
+	return mix(y ^ key ^ ySalt);
+}
+
+// one draw for the block column at x, y
+constexpr u16 at(u32 key, int x, int y) {
+	return mix(hashX(key, x) ^ hashY(key, y)) >> (x & 1) * 16;
+}
+
+constexpr int columnSize = chunkSize * chunkSize;
+
+// at(key, x0 + i, y0 + j) for a whole chunk column, stored as out[i + j * 16];
+// x0 is even, as it is for every chunk column
+void column(u32 key, int x0, int y0, u16 *out);
+
+}
@@ -1,4 +1,5 @@
 #include "scheduler.hpp"
+#include "chunkcache.hpp"
 
 namespace {
 
@@ -8,22 +9,27 @@ namespace {
     std::vector<s16vec3> scheduledMeshes; // todo array
 
 
+    // generation jobs in flight, a whole column counting as one
     constexpr int maxScheduledChunks = 8;
-    
+
+    // a column job is listed once, with z set to wholeColumn
+    constexpr s16 wholeColumn = -0x8000;
+
     std::vector<s16vec3> scheduledChunks;
 
+    bool columnJobs = true;
+
 }
 
 ChunkMetadata *getOrScheduleChunk(s16 x, s16 y, s16 z) {
 
-	auto it = world.find({x, y, z});
-
-	if (it != world.end())
-		return &it->second;
+	if (auto *meta = world.find(x, y, z))
+		return meta;
 
 	else {
 		scheduleChunk(x, y, z); // todo: use this bool somehow
-		return nullptr;
+		// it may have come straight back from the chunk cache
+		return tryGetChunk(x, y, z);
 	}
 }
 
@@ -32,51 +38,54 @@ Block getOrScheduleBlock(int x, int y, int z) {
 	auto *ch = getOrScheduleChunk(x >> chunkBits, y >> chunkBits, z >> chunkBits);
 
 	if (ch != nullptr)
-		return (*ch->data)[z & chunkMask][y & chunkMask][x & chunkMask];
+		return ch->blocks.get(x & chunkMask, y & chunkMask, z & chunkMask);
 	else
 		return { 0xffff };
 }
 
-bool getOrScheduleSides(int x, int y, int z, std::array<chunk *, 6> &out) {
-
-	auto _g = [&out](int i, int _x, int _y, int _z) -> bool {
+bool getOrScheduleNeighbours(int x, int y, int z, ChunkNeighbourhood &out) {
 
-		if (_z < -zChunks || _z > zChunks) {
-			out[i] = nullptr;
-			return true;
-		}
+	// stops at the first missing chunk, like the rest of the loading it gets retried
+	for (int dz = -1; dz < 2; ++dz)
+		for (int dy = -1; dy < 2; ++dy)
+			for (int dx = -1; dx < 2; ++dx) {
 
-		auto *m = getOrScheduleChunk(_x, _y, _z);
-		out[i] = m ? m->data : nullptr;
+				auto &o = out[neighbourIndex(dx, dy, dz)];
+				if (z + dz < -zChunks || z + dz > zChunks) {
+					o = nullptr;
+					continue;
+				}
 
-		return out[i] != nullptr;
-	};
+				auto *m = getOrScheduleChunk(x + dx, y + dy, z + dz);
+				if (!m)
+					return false;
+				o = &m->blocks;
+			}
 
-	return (
-		_g(0, x-1, y, z) &&
-		_g(1, x+1, y, z) &&
-		_g(2, x, y-1, z) &&
-		_g(3, x, y+1, z) &&
-		_g(4, x, y, z-1) &&
-		_g(5, x, y, z+1)
-	);
+	return true;
 }
 
-bool scheduleMesh(
-	ChunkMetadata &meta,
-	std::array<chunk *, 6> const &sides,
-	s16vec3 idx, bool priority);
+bool scheduleMesh(ChunkNeighbourhood const &chunks, s16vec3 idx, bool priority, MeshSegments const &segments, u8 flags);
+
+// edited chunks get their connectivity worked out again along with the mesh
+u8 meshFlags(ChunkMetadata const &meta) {
+	return meta.modified ? Task::TASK_VISIBILITY : 0;
+}
 
-// already loaded chunk changed, force remeshing
-// take care of the return value, store it in a list?
+// already meshed chunk changed, rebuild the segments next to the dirty layers;
+// the result gets spliced into the current mesh
 bool regenerateMesh(ChunkMetadata &meta, s16 x, s16 y, s16 z) {
 
-	std::array<chunk *, 6> sides { nullptr };
+	ChunkNeighbourhood chunks { nullptr };
+
+	if (!getOrScheduleNeighbours(x, y, z, chunks))
+		return false;
 
-	if (!getOrScheduleSides(x, y, z, sides))
+	if (!scheduleMesh(chunks, {x, y, z}, true, dirtySegments(meta.dirty), meshFlags(meta)))
 		return false;
 
-	return scheduleMesh(meta, sides, {x, y, z}, true);
+	meta.dirty = {};
+	return true;
 }
 
 bool isMeshScheduled(s16vec3 idx);
@@ -85,15 +94,23 @@ bool tryMakeMesh(ChunkMetadata &meta, s16 x, s16 y, s16 z) {
 	if (meta.meshed)
 		return true;
 
+	// nothing to draw in a chunk of plain air, skip the worker entirely
+	if (meta.blocks.isUniform() && meta.blocks.fill.isAir()) {
+		meta.meshed = true;
+		return true;
+	}
+
 	s16vec3 idx { x, y, z };
 	if (isMeshScheduled(idx))
 		return false;
 
-	std::array<chunk *, 6> sides { nullptr };
-	if (!getOrScheduleSides(x, y, z, sides))
+	ChunkNeighbourhood chunks { nullptr };
+	if (!getOrScheduleNeighbours(x, y, z, chunks))
 		return false;
 
-	scheduleMesh(meta, sides, idx, true);
+	// the whole chunk gets meshed, edits up to here included
+	if (scheduleMesh(chunks, idx, true, MeshSegments().set(), meshFlags(meta)))
+		meta.dirty = {};
 	return false;
 }
 
@@ -106,17 +123,13 @@ bool tryInitChunkAndMesh(int x, int y, int z) {
 	return tryMakeMesh(*ch, x, y, z);
 }
 
-bool scheduleMesh(
-	ChunkMetadata &meta,
-	std::array<chunk *, 6> const &sides,
-	s16vec3 idx, bool priority
-) {
-	// todo: caller could check for this to save time on gathering sides
+bool scheduleMesh(ChunkNeighbourhood const &chunks, s16vec3 idx, bool priority, MeshSegments const &segments, u8 flags) {
+	// todo: caller could check for this to save time on gathering neighbours
 	if (!canProcessMeshes(priority))
 		return false;
 
-	// no check for scheduled since they can have different chunk data;
-	// call to force remeshing, or check separately to avoid moving data
+	// callers keep to one mesh task per chunk (isMeshScheduled), so that
+	// patches get spliced into the mesh they were made against
 
 	scheduledMeshes.push_back(idx);
 
@@ -125,46 +138,87 @@ bool scheduleMesh(
 	task.chunk.y = idx.y;
 	task.chunk.z = idx.z;
 
-	task.chunk.exdata = new expandedChunk{0}; // todo cache allocations
+	// the worker expands it; edits made meanwhile copy the chunk instead of racing it
+	task.chunk.snapshot = takeSnapshot(chunks, segments);
 	task.type = Task::Type::MeshChunk;
+	task.flags = flags;
 
-	expandChunk(*meta.data, sides, *task.chunk.exdata);
+	if (postTask(task, priority))
+		return true;
 
-	return postTask(task, priority);
+	releaseSnapshot(task.chunk.snapshot);
+	scheduledMeshReceived(idx);
+	return false;
 }
 
 bool canProcessChunks() {
 	return scheduledChunks.size() < maxScheduledChunks;
 }
 
-bool scheduleChunk(s16 x, s16 y, s16 z) {
+// puts back an unmodified chunk seen before, without going through the worker
+bool restoreCachedChunk(s16vec3 idx) {
 
-	if (!canProcessChunks())
+	ChunkBlocks blocks;
+	u16 connectivity;
+	if (!chunkcache::take(idx, blocks, connectivity))
 		return false;
 
+	auto &meta = *world.insert(idx);
+
+	if (getPaletteChunks())
+		blocks.pack();
+	meta.blocks = blocks;
+	meta.connectivity = connectivity;
+	return true;
+}
+
+bool scheduleChunk(s16 x, s16 y, s16 z) {
+
 	s16vec3 idx {x, y, z};
 
+	// the slot still holds a chunk left behind the player; wait for the unload pass
+	if (!world.vacant(idx))
+		return false;
+
+	if (restoreCachedChunk(idx))
+		return true;
+
+	if (!canProcessChunks())
+		return false;
+
 	for (auto &c: scheduledChunks)
-		if (c == idx)
+		if (c == idx || (c.z == wholeColumn && c.x == x && c.y == y))
 			return true;
 
-	scheduledChunks.push_back(idx);
-
 	Task task;
 	task.chunk.x = x;
 	task.chunk.y = y;
 	task.chunk.z = z;
-	task.type = Task::Type::GenerateChunk;
-	return postTask(task);
+
+	// chunks of the column that are still loaded get their copy thrown away on arrival
+	task.type = columnJobs ? Task::Type::GenerateColumn : Task::Type::GenerateChunk;
+
+	if (!postTask(task))
+		return false;
+
+	scheduledChunks.push_back(columnJobs ? s16vec3 {x, y, wholeColumn} : idx);
+	return true;
+}
+
+void setColumnJobs(bool enabled) {
+	columnJobs = enabled;
 }
 
+// a column job ends with its top chunk
 void scheduledChunkReceived(s16vec3 idx) {
-    for (size_t i = 0; i < scheduledChunks.size(); ++i)
-    if (scheduledChunks[i] == idx) {
-        scheduledChunks[i] = scheduledChunks.back();
-        scheduledChunks.pop_back();
+    for (size_t i = 0; i < scheduledChunks.size();) {
+        auto &c = scheduledChunks[i];
+        if (c == idx || (idx.z == zChunks && c.z == wholeColumn && c.x == idx.x && c.y == idx.y)) {
+            c = scheduledChunks.back();
+            scheduledChunks.pop_back();
+        } else
+            ++i;
     }
-
 }
 
 bool canProcessMeshes(bool priority) {
@@ -5,7 +5,7 @@
 
 // todo: organise these functions better
 
-WorldMap::iterator destroyChunk(WorldMap::iterator it);
+void destroyChunk(WorldMap::Slot &slot);
 
 void destroyChunk(s16vec3 v);
 
@@ -15,7 +15,8 @@ ChunkMetadata *getOrScheduleChunk(s16 x, s16 y, s16 z);
 
 Block getOrScheduleBlock(int x, int y, int z);
 
-bool getOrScheduleSides(int x, int y, int z, std::array<chunk *, 6> &out);
+// the chunk and all 26 neighbours, false until they are all loaded
+bool getOrScheduleNeighbours(int x, int y, int z, ChunkNeighbourhood &out);
 
 bool regenerateMesh(ChunkMetadata &meta, s16 x, s16 y, s16 z);
 
@@ -25,18 +26,16 @@ bool tryInitChunkAndMesh(int x, int y, int z);
 
 bool canProcessChunks();
 
+// generate whole columns at once instead of single chunks
+void setColumnJobs(bool enabled);
+
 bool scheduleChunk(s16 x, s16 y, s16 z);
 
 void scheduledChunkReceived(s16vec3 idx);
 
 bool canProcessMeshes(bool priority);
 
-bool scheduleMesh(
-	ChunkMetadata &meta,
-	std::array<chunk *, 6> const &sides,
-	s16vec3 idx, 
-    bool priority
-);
+bool scheduleMesh(ChunkNeighbourhood const &chunks, s16vec3 idx, bool priority, MeshSegments const &segments, u8 flags);
 
 void scheduledMeshReceived(s16vec3 idx);
 
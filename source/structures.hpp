@@ -0,0 +1,107 @@
+#pragma once
+#include "common.hpp"
+#include "rng.hpp"
+
+#include <algorithm>
+
+// decoration templates, built at compile time and blitted into chunks as is
+
+namespace worldgen {
+
+// box of blocks around a root; hard cells overwrite the terrain, soft ones only fill air.
+// cells are [z][y][x] like chunks, air means the cell is not part of the structure
+template <int W, int D, int H>
+struct Structure {
+	s8 rootX, rootY, rootZ; // root position inside the box
+	Block hard[H][D][W] {};
+	Block soft[H][D][W] {};
+
+	// relative to the root
+	constexpr void set(int x, int y, int z, Block block, bool isSoft) {
+		(isSoft ? soft : hard)[z + rootZ][y + rootY][x + rootX] = block;
+	}
+};
+
+// size-erased view of a structure, for the placement table
+struct StructureRef {
+	Block const *hard = nullptr;
+	Block const *soft = nullptr;
+	s8 rootX = 0, rootY = 0, rootZ = 0;
+	u8 w = 0, d = 0, h = 0;
+
+	constexpr StructureRef() = default;
+
+	template <int W, int D, int H>
+	constexpr StructureRef(Structure<W, D, H> const &s):
+		hard(&s.hard[0][0][0]), soft(&s.soft[0][0][0]),
+		rootX(s.rootX), rootY(s.rootY), rootZ(s.rootZ), w(W), d(D), h(H) {}
+};
+
+constexpr int treeVariants = 16;
+
+// trunk, leaf crown and five hashed branches; the crown and trunk are shared by
+// all variants, the branch offsets and their leaves come from the variant
+using TreeStructure = Structure<6, 6, 6>;
+
+constexpr u32 treeBranchKey = 1;
+constexpr u32 treeLeafKey = 2;
+
+constexpr TreeStructure makeTree(u32 variant) {
+
+	TreeStructure t { 2, 2, 0 };
+
+	for (int lz = 0; lz < 2; ++lz)
+		for (int ly = -1; ly < 2; ++ly)
+			for (int lx = -1; lx < 2; ++lx)
+				t.set(lx, ly, 2 + lz, Block::solid(25), true);
+
+	const int branches = 5;
+	for (int i = 0; i < branches; ++i) {
+
+		auto h = rng::at(treeBranchKey, variant, i);
+		int bx = h & 0x3; if (bx > 2) bx = 2 - bx;
+		int by = (h >> 3) & 0x3; if (by > 2) by = 2 - by;
+		int bz = (h >> 6) & 0x3; if (bz == 3) bz = 0;
+
+		for (int lz = 0; lz < 2; ++lz)
+			for (int ly = -1; ly < 2; ++ly)
+				for (int lx = -1; lx < 2; ++lx)
+					if (rng::at(treeLeafKey, variant * branches + i, (lz * 3 + ly + 1) * 3 + lx + 1) & 0x3)
+						t.set(bx + lx, by + ly, bz + 2 + lz, Block::solid(25), true);
+	}
+
+	for (int iz = 0; iz < 3; ++iz)
+		t.set(0, 0, iz, Block::solid(24), false);
+
+	return t;
+}
+
+inline constexpr auto treeTemplates = [] {
+	std::array<TreeStructure, treeVariants> trees {};
+	for (int i = 0; i < treeVariants; ++i)
+		trees[i] = makeTree(i);
+	return trees;
+}();
+
+// placement ids; new features append their variants here
+constexpr u8 structureTree = 0;
+constexpr int structureCount = structureTree + treeVariants;
+
+inline constexpr auto structures = [] {
+	std::array<StructureRef, structureCount> s;
+	for (int i = 0; i < treeVariants; ++i)
+		s[structureTree + i] = treeTemplates[i];
+	return s;
+}();
+
+// largest distance a structure reaches from its root, in x and y
+constexpr int maxStructureReach = [] {
+	int reach = 0;
+	for (auto &s: structures)
+		reach = std::max({ reach, (int)s.rootX, (int)s.rootY, s.w - 1 - s.rootX, s.d - 1 - s.rootY });
+	return reach;
+}();
+
+static_assert(maxStructureReach < chunkSize, "decoration only looks at the 3x3 column neighbourhood");
+
+}
@@ -1,11 +1,16 @@
 #include "worker.hpp"
 
 #include "worldgen.hpp"
+#include "region.hpp"
 #include "mesher.hpp"
 
 namespace {
 
     volatile bool runWorker = true;
+    volatile bool paletteChunks = true;
+
+    // too large for the worker stack
+    thread_local expandedChunk meshScratch;
 
     Thread workerThread;
 
@@ -36,47 +41,98 @@ namespace {
 }
 
 bool postResult(TaskResult result);
+
+// the main thread empties the results once a frame; a dropped result would leak its
+// chunk or mesh and leave it scheduled for good, so wait for room. false on shutdown
+bool waitPostResult(TaskResult const &r) {
+    while (!postResult(r)) {
+        if (!runWorker)
+            return false;
+        svcSleepThread(1000000);
+    }
+    return true;
+}
+
+// connectivity is taken first, on the dense array
+void setChunkResult(TaskResult &r, ChunkBlocks &blocks) {
+    r.chunk.connectivity = getConnectivity(blocks);
+    if (paletteChunks)
+        blocks.pack();
+    r.chunk.data = blocks.dense;
+    r.chunk.fill = blocks.fill;
+    r.chunk.paletted = blocks.paletted;
+}
+
 void processTask(Task &t) {
 
     TaskResult r;
 
     switch (t.type) {
 
-        case Task::Type::GenerateChunk:
+        case Task::Type::GenerateChunk: {
 
             r.type = TaskResult::Type::ChunkData;
-            r.chunk.data = generateChunk(t.chunk.x, t.chunk.y, t.chunk.z);
+            ChunkBlocks blocks;
+            if (!region::loadChunk(t.chunk.x, t.chunk.y, t.chunk.z, blocks))
+                blocks = generateChunk(t.chunk.x, t.chunk.y, t.chunk.z);
+            setChunkResult(r, blocks);
             r.chunk.x = t.chunk.x; r.chunk.y = t.chunk.y; r.chunk.z = t.chunk.z;
 
-            r.chunk.visibility = getSidesOpaque(*r.chunk.data);
+            if (!waitPostResult(r))
+                blocks.release();
+        } break;
 
-            postResult(r);
-            break;
+        case Task::Type::GenerateColumn: {
 
-        case Task::Type::MeshChunk:
+            std::array<ChunkBlocks, columnChunks> blocks;
+            if (!region::loadColumn(t.chunk.x, t.chunk.y, blocks))
+                generateColumnChunks(t.chunk.x, t.chunk.y, blocks);
+
+            r.type = TaskResult::Type::ChunkData;
+            r.chunk.x = t.chunk.x; r.chunk.y = t.chunk.y;
+
+            // bottom first; the top chunk arriving tells the scheduler the job is done
+            for (int i = 0; i < columnChunks; ++i) {
+                setChunkResult(r, blocks[i]);
+                r.chunk.z = i - zChunks;
+                if (!waitPostResult(r)) {
+                    for (int j = i; j < columnChunks; ++j)
+                        blocks[j].release();
+                    break;
+                }
+            }
+        } break;
+
+        case Task::Type::MeshChunk: {
 
             r.type = TaskResult::Type::ChunkMesh;
 
+            // let go of the chunks early, so edits on the main thread rarely need a copy
+            expandSnapshot(*t.chunk.snapshot, meshScratch);
+            auto segments = t.chunk.snapshot->segments;
+            releaseSnapshot(t.chunk.snapshot);
+
             if (t.flags & Task::TASK_VISIBILITY) {
-                r.chunk.visibility = getSidesOpaque(*t.chunk.exdata);
+                r.chunk.connectivity = getConnectivity(meshScratch);
                 r.flags |= TaskResult::RESULT_VISIBILITY;
             }
 
-            // todo make these allocs saner
-            r.chunk.alloc = new MesherAllocation;
-            *r.chunk.alloc = meshChunk(*t.chunk.exdata);
-            delete t.chunk.exdata;
+            r.chunk.alloc = meshAllocationPool.create();
+            *r.chunk.alloc = meshChunk(meshScratch, segments);
             r.chunk.x = t.chunk.x; r.chunk.y = t.chunk.y; r.chunk.z = t.chunk.z;
 
-            postResult(r);
-            break;
+            if (!waitPostResult(r)) {
+                freeMesh(*r.chunk.alloc);
+                meshAllocationPool.destroy(r.chunk.alloc);
+            }
+        } break;
 
         case Task::Type::Tag:
 
             r.type = TaskResult::Type::Tag;
             r.value = t.value;
 
-            postResult(r);
+            waitPostResult(r);
             break;
 
         default: break;
@@ -104,6 +160,14 @@ void workerMain(void *arg) {
     LightLock_Unlock(&tasks.lock);
 }
 
+void setPaletteChunks(bool enabled) {
+    paletteChunks = enabled;
+}
+
+bool getPaletteChunks() {
+    return paletteChunks;
+}
+
 void startWorker() {
 
     s32 prio = 0;
@@ -6,6 +6,7 @@
 struct Task {
     enum class Type: u8 {
         GenerateChunk,
+        GenerateColumn, // all chunks of column x, y
         MeshChunk,
         Tag,
     };
@@ -13,14 +14,14 @@ struct Task {
         void *ptr;
         u32 value;
         struct {
-            expandedChunk *exdata;
+            MeshSnapshot *snapshot;
             s16 x, y, z;
         } chunk;
     };
     Type type;
-    u8 flags; 
+    u8 flags = 0;
 
-    static constexpr int TASK_VISIBILITY = 1;
+    static constexpr int TASK_VISIBILITY = 1; // also work out the chunk's connectivity
 };
 
 struct TaskResult {
@@ -37,14 +38,20 @@ struct TaskResult {
                 MesherAllocation *alloc;
             };
             s16 x, y, z;
-            u8 visibility;
+            u16 connectivity;
+            Block fill; // for uniform chunks without data
+            PalettedChunk *paletted; // instead of data, see setPaletteChunks
         } chunk;
     };
     Type type;
-    u8 flags;
+    u8 flags = 0;
     static constexpr int RESULT_VISIBILITY = 1;
 };
 
+// generated chunks get packed into a palette where it is smaller than the dense array
+void setPaletteChunks(bool enabled);
+bool getPaletteChunks();
+
 void startWorker();
 void stopWorker();
 bool postTask(Task task, bool priority = false);
@@ -1,4 +1,8 @@
 #include "world.hpp"
+#include "chunkcache.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 // https://github.com/fenomas/fast-voxel-raycast/blob/master/index.js
 bool raycast(fvec3 eye, fvec3 dir, float maxLength, vec3<s32> &out, vec3<s32> &normal) {
@@ -82,26 +86,98 @@ bool raycast(fvec3 eye, fvec3 dir, float maxLength, vec3<s32> &out, vec3<s32> &n
 	return false;
 }
 
-WorldMap::iterator destroyChunk(WorldMap::iterator it) {
-	delete it->second.data;
-	freeMesh(it->second.allocation);
-	return world.erase(it);
+bool findVisibleChunks(s16vec3 camera, int maxDistance, std::vector<WorldMap::Slot *> &out) {
+
+	out.clear();
+
+	// chunks are told apart by slot, which holds while the walk fits in the grid
+	maxDistance = std::min(maxDistance, distanceUnload);
+
+	int start = WorldMap::slotIndex(camera.x, camera.y, camera.z);
+	if (start < 0 || !world.slots[start].used || world.slots[start].idx != camera)
+		return false;
+
+	struct Step {
+		s16vec3 idx;
+		s8 from; // face it was entered through, -1 for the camera's chunk
+		u8 directions; // taken on the way here
+	};
+
+	// faces each chunk was entered through this walk; one entered again through
+	// another face can lead further, so it is walked again but listed once
+	static std::array<u32, WorldMap::size> stamps {};
+	static std::array<u8, WorldMap::size> entered;
+	static std::vector<Step> queue;
+	static u32 stamp = 0;
+
+	constexpr s16vec3 offsets[chunkFaces] = {
+		{ -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }
+	};
+
+	++stamp;
+	queue.clear();
+	queue.push_back({ camera, -1, 0 });
+	stamps[start] = stamp;
+	entered[start] = 0;
+	out.push_back(&world.slots[start]);
+
+	for (size_t q = 0; q < queue.size(); ++q) {
+
+		auto step = queue[q];
+		auto *meta = world.find(step.idx);
+		u16 connectivity = meta ? meta->connectivity : allFacesConnected;
+
+		for (int d = 0; d < chunkFaces; ++d) {
+
+			if (step.directions & (1 << (d ^ 1)))
+				continue;
+			if (step.from >= 0 && !facesConnected(connectivity, step.from, d))
+				continue;
+
+			s16vec3 n { (s16)(step.idx.x + offsets[d].x), (s16)(step.idx.y + offsets[d].y), (s16)(step.idx.z + offsets[d].z) };
+			int dx = n.x - camera.x, dy = n.y - camera.y, dz = n.z - camera.z;
+			if (dx*dx + dy*dy + dz*dz > maxDistance * maxDistance)
+				continue;
+
+			int i = WorldMap::slotIndex(n.x, n.y, n.z);
+			if (i < 0)
+				continue;
+
+			// a chunk that is not resident yet could be open anywhere, so the walk goes on
+			// through it as if all its faces were joined; only resident ones are listed
+			u8 face = 1 << (d ^ 1);
+			if (stamps[i] != stamp) {
+				stamps[i] = stamp;
+				entered[i] = 0;
+				if (world.slots[i].used && world.slots[i].idx == n)
+					out.push_back(&world.slots[i]);
+			} else if (entered[i] & face)
+				continue;
+			entered[i] |= face;
+
+			queue.push_back({ n, (s8)(d ^ 1), (u8)(step.directions | 1 << d) });
+		}
+	}
+
+	return true;
+}
+
+void destroyChunk(WorldMap::Slot &slot) {
+	if (!slot.value.modified)
+		chunkcache::store(slot.idx, slot.value.blocks, slot.value.connectivity);
+	slot.value.blocks.release();
+	freeMesh(slot.value.allocation);
+	world.erase(slot);
 }
 
 void destroyChunk(s16vec3 v) {
-	auto it = world.find(v);
-	if (it != world.end())
-		destroyChunk(it);
+	int i = WorldMap::slotIndex(v.x, v.y, v.z);
+	if (i >= 0 && world.slots[i].used && world.slots[i].idx == v)
+		destroyChunk(world.slots[i]);
 }
 
 ChunkMetadata *tryGetChunk(s16 x, s16 y, s16 z) {
-
-	auto it = world.find({x, y, z});
-
-	if (it != world.end())
-		return &it->second;
-	else 
-		return nullptr;
+	return world.find(x, y, z);
 }
 
 Block tryGetBlock(int x, int y, int z) {
@@ -109,7 +185,7 @@ Block tryGetBlock(int x, int y, int z) {
 	auto *ch = tryGetChunk(x >> chunkBits, y >> chunkBits, z >> chunkBits);
 
 	if (ch != nullptr)
-		return (*ch->data)[z & chunkMask][y & chunkMask][x & chunkMask];
+		return ch->blocks.get(x & chunkMask, y & chunkMask, z & chunkMask);
 	else
 		return { 0xffff };
 }
\ No newline at end of file
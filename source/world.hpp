@@ -1,22 +1,46 @@
 #pragma once
 
+#include "chunkgrid.hpp"
 #include "common.hpp"
 #include "mesher.hpp"
 
 struct ChunkMetadata {
 	MesherAllocation allocation;
 	C3D_BufInfo vertexBuffer;
-	chunk *data = nullptr;
-	u8 visibility = 0;
+	ChunkBlocks blocks;
+	u16 connectivity = 0; // faces joined through the chunk, see getConnectivity
 	bool meshed = false;
+	bool modified = false; // edited by the player, cannot be regenerated
+	// blocks changed since the last mesh task, a bit per layer along x, y and z;
+	// bit 0 and chunkSize + 1 are the layers of the neighbours next to the chunk
+	std::array<u32, 3> dirty {};
+
+	bool isDirty() const { return dirty[0] | dirty[1] | dirty[2]; }
 };
 
-using WorldMap = std::unordered_map<s16vec3, ChunkMetadata, s16vec3::hash>;
+// note that a 1-chunk thick shell will generate outside the render cage since it is needed for meshing
+static constexpr int distanceLoad = 6; // blocks to load, cage size 2n+1
+static constexpr int distanceUnload = 8; // blocks to unload, keep blocks in cage of 2n+1
+
+// resident chunks, one slot per position in the unload cage
+using WorldMap = ChunkGrid<ChunkMetadata, distanceUnload * 2 + 1, -zChunks, zChunks>;
 inline WorldMap world;
 
+// a chunk needed for loading or meshing can only find its slot taken by one outside the
+// unload cage, which the unload pass clears
+static_assert(distanceLoad + 1 + distanceUnload < distanceUnload * 2 + 1);
+
 bool raycast(fvec3 eye, fvec3 dir, float maxLength, vec3<s32> &out, vec3<s32> &normal);
 
-WorldMap::iterator destroyChunk(WorldMap::iterator it);
+// resident chunks that can be seen from the camera's chunk, nearest first, within
+// maxDistance chunks. a breadth first walk that crosses a chunk only between faces
+// its open blocks join and never heads back towards the camera, so chunks walled off
+// underground or behind hills are never reached. chunks that are not resident are
+// walked through as open. false when the camera's chunk is not resident, then there
+// is nothing to walk from
+bool findVisibleChunks(s16vec3 camera, int maxDistance, std::vector<WorldMap::Slot *> &out);
+
+void destroyChunk(WorldMap::Slot &slot);
 
 void destroyChunk(s16vec3 v);
 
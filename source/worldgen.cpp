@@ -1,65 +1,212 @@
 #include "worldgen.hpp"
+#include "chunkmap.hpp"
 
 #include "noise.hpp"
 #include "dcsimplex.hpp"
-#include <unordered_map>
+#include "rng.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
 
 using namespace worldgen;
 
+static_assert(noiseGridSize == chunkSize);
+
 namespace {
 
-// constexpr int columnCache = 8*8;
+constexpr u16 noSlot = 0xffff;
+
+struct CacheSlot {
+	Column column;
+	vec2<s16> key;
+	u16 prev = noSlot; // towards most recently used
+	u16 next = noSlot;
+	u16 pins = 0; // jobs using the column; pinned slots are never evicted
+};
+
+// pool of columns with an intrusive lru list, split in shards with a lock each;
+// slots are allocated one by one so references stay valid until evicted
+struct CacheShard {
+	LightLock lock;
+	ChunkMap<u16> index;
+	std::vector<std::unique_ptr<CacheSlot>> slots;
+	u16 head = noSlot;
+	u16 tail = noSlot;
+	int budget = defaultColumnCacheBudget / columnCacheShards;
+	ColumnCacheStats stats;
+
+	CacheShard() { LightLock_Init(&lock); }
+};
+
+std::array<CacheShard, columnCacheShards> cache;
+
+INLINE CacheShard &shardOf(vec2<s16> key) {
+	return cache[(key.x + key.y * 2) & (columnCacheShards - 1)];
+}
 
-// todo: we need to evict from cache ocassionally; maybe a separate job?
-std::unordered_map<vec2<s16>, Column, vec2<s16>::hash> cache;
-//u32 cacheIndex = 0;
+void lruUnlink(CacheShard &shard, u16 i) {
+	auto &s = *shard.slots[i];
+	if (s.prev != noSlot) shard.slots[s.prev]->next = s.next; else shard.head = s.next;
+	if (s.next != noSlot) shard.slots[s.next]->prev = s.prev; else shard.tail = s.prev;
+	s.prev = s.next = noSlot;
+}
 
-INLINE u32 xorshift(u32 v, int s) {
-	return v ^ (v >> s);
+void lruPushFront(CacheShard &shard, u16 i) {
+	auto &s = *shard.slots[i];
+	s.prev = noSlot;
+	s.next = shard.head;
+	if (shard.head != noSlot)
+		shard.slots[shard.head]->prev = i;
+	shard.head = i;
+	if (shard.tail == noSlot)
+		shard.tail = i;
 }
 
-// todo come up with something better
-INLINE u32 simpleHash(u32 a, u32 b, u32 c) {
-	u32 i = xorshift(a * (u32)0x1234567, 16);//0x55555555
-	u32 j = xorshift((b + i) * (u32)1073726623, 16);
-    u32 k = xorshift((c + j) * (u32)2654435761, 16);
-    return k;
+// least recently used unpinned slot, or a new one; while every slot is
+// pinned by jobs in flight the shard goes over its budget
+u16 acquireSlot(CacheShard &shard, vec2<s16> key) {
+
+	u16 i = shard.tail;
+	if ((int)shard.slots.size() >= shard.budget)
+		while (i != noSlot && shard.slots[i]->pins)
+			i = shard.slots[i]->prev;
+
+	if ((int)shard.slots.size() < shard.budget || i == noSlot) {
+		i = shard.slots.size();
+		shard.slots.push_back(std::make_unique<CacheSlot>());
+	} else {
+		lruUnlink(shard, i);
+		auto &old = shard.slots[i]->key;
+		shard.index.erase(chunkKey(old.x, old.y));
+		++shard.stats.evictions;
+	}
+
+	shard.slots[i]->key = key;
+	shard.index[chunkKey(key.x, key.y)] = i;
+	lruPushFront(shard, i);
+	return i;
 }
 
-constexpr int maxTreeRadius = 1;
+// stock pipeline, caves and ore get swapped by setDensityLattice
+Pipeline pipeline {
+	heightmapStage,
+	exactCavesStage,
+	exactOreStage,
+	surfaceStage,
+	decorationStage,
+};
+
+struct {
+	std::atomic<u32> calls;
+	std::atomic<u64> ticks;
+} stageStats[(int)Stage::Count];
+
+INLINE void addStageTime(Stage stage, u64 start) {
+	auto &stats = stageStats[(int)stage];
+	stats.ticks.fetch_add(svcGetSystemTick() - start, std::memory_order_relaxed);
+	stats.calls.fetch_add(1, std::memory_order_relaxed);
+}
 
-Column &generateColumn(s16 cx, s16 cy) {
+void runStage(Stage stage, void (*run)(GenJob &), GenJob &job) {
+	u64 start = svcGetSystemTick();
+	run(job);
+	addStageTime(stage, start);
+}
 
-	auto &c = cache[{ cx, cy }];
+// the column stays cached until unpinned
+CacheSlot &pinColumn(s16 x, s16 y) {
 
-	for (int ly = 0; ly < chunkSize; ++ly)
-		for (int lx = 0; lx < chunkSize; ++lx) {
+	auto &shard = shardOf({ x, y });
+	LightLock_Lock(&shard.lock);
+
+	if (auto *i = shard.index.find(chunkKey(x, y))) {
+		++shard.stats.hits;
+		lruUnlink(shard, *i);
+		lruPushFront(shard, *i);
+		auto &slot = *shard.slots[*i];
+		++slot.pins;
+		LightLock_Unlock(&shard.lock);
+		return slot;
+	}
 
-			int x = lx + cx * chunkSize;
-			int y = ly + cy * chunkSize;
+	++shard.stats.misses;
+	auto &slot = *shard.slots[acquireSlot(shard, { x, y })];
+	slot.pins = 1;
 
-			auto &b = c.blocks[ly][lx];
+	// other jobs wanting this shard wait for the heightmap, which is cheap
+	auto &c = slot.column;
+	u64 start = svcGetSystemTick();
+	pipeline.heightmap(c, x, y);
+	addStageTime(Stage::Heightmap, start);
 
-			b.height = noise2d(0, x*0.02f, y*0.02f) * 4 + chunkSize/2;
+	c.placements.clear();
+	c.placementsGenerated = false;
+
+	LightLock_Unlock(&shard.lock);
+	return slot;
+}
 
-			b.grass = (simpleHash(x, y, 0) & 0xf) == 0; // 1 in 16
+// frees slot i, moving the last slot into its place
+void dropSlot(CacheShard &shard, u16 i) {
+
+	lruUnlink(shard, i);
+	auto &key = shard.slots[i]->key;
+	shard.index.erase(chunkKey(key.x, key.y));
+	++shard.stats.evictions;
+
+	u16 last = shard.slots.size() - 1;
+	if (i != last) {
+		auto &s = *shard.slots[last];
+		if (s.prev != noSlot) shard.slots[s.prev]->next = i; else shard.head = i;
+		if (s.next != noSlot) shard.slots[s.next]->prev = i; else shard.tail = i;
+		shard.index[chunkKey(s.key.x, s.key.y)] = i;
+		shard.slots[i] = std::move(shard.slots[last]);
+	}
+	shard.slots.pop_back();
+}
 
-			b.tree = (simpleHash(x, y, 0) & 0x7f) == 5; // 1 in 128
+// a shard that went over its budget while pinned shrinks back as pins are released
+void unpinColumn(CacheSlot &slot) {
+	auto &shard = shardOf(slot.key);
+	LightLock_Lock(&shard.lock);
+	--slot.pins;
+	for (u16 i = shard.tail; (int)shard.slots.size() > shard.budget && i != noSlot;) {
+		u16 prev = shard.slots[i]->prev;
+		if (!shard.slots[i]->pins) {
+			u16 last = shard.slots.size() - 1;
+			dropSlot(shard, i);
+			if (prev == last) // moved into the dropped slot's place
+				prev = i;
 		}
+		i = prev;
+	}
+	LightLock_Unlock(&shard.lock);
+}
 
-	return c;
+bool hasPlacements(CacheSlot &slot) {
+	auto &shard = shardOf(slot.key);
+	LightLock_Lock(&shard.lock);
+	bool has = slot.column.placementsGenerated;
+	LightLock_Unlock(&shard.lock);
+	return has;
 }
 
-Column &getColumn(s16 x, s16 y) {
-	auto it = cache.find({ x, y });
-	if (it == cache.end())
-		return generateColumn(x, y);
-	else
-		return it->second;
+// placements are immutable once set; a job that lost the race drops its copy
+void publishPlacements(s16 x, s16 y, placementList &placements) {
+	auto &shard = shardOf({ x, y });
+	LightLock_Lock(&shard.lock);
+	auto &c = shard.slots[*shard.index.find(chunkKey(x, y))]->column;
+	if (!c.placementsGenerated) {
+		c.placements = std::move(placements);
+		c.placementsGenerated = true;
+	}
+	LightLock_Unlock(&shard.lock);
 }
 
-dcs::Seed n1(0);
-dcs::Seed n2(1);
+constexpr u32 decorationKey = 0;
+
+constexpr dcs::Seed n1(0);
+constexpr dcs::Seed n2(1);
 
 constexpr float tunnelScaleXY = 1.0f / 48;
 constexpr float tunnelScaleZ = 1.0f / 32;
@@ -115,9 +262,344 @@ INLINE bool isTunnel(dcs::DrvGenerator &gen1, dcs::DrvGenerator &gen2, int z) {
 	return true;
 }
 
+INLINE float tunnelDensity(std::array<float, 4> const &dx1, std::array<float, 4> const &dx2, int z) {
+
+	float density = dx1[0] * dx1[0] + dx2[0] * dx2[0];
+
+	float noiseDeltaMagSq1 = dx1[1]*dx1[1] + dx1[2]*dx1[2] + dx1[3]*dx1[3];
+	float noiseDeltaMagSq2 = dx2[1]*dx2[1] + dx2[2]*dx2[2] + dx2[3]*dx2[3];
+	float noiseDeltaDot = dx1[1]*dx2[1] + dx1[2]*dx2[2] + dx1[3]*dx2[3];
+
+	float sqNormDot = (noiseDeltaDot * noiseDeltaDot) / (noiseDeltaMagSq1 * noiseDeltaMagSq2);
+	density += (sqNormDot * sqNormDot) * (tunnelThreshold2 * tunnelClosing);
+
+	int belowCutoff = tunnelZeroCutoff - z;
+	if (belowCutoff > 0)
+		density += (belowCutoff * tunnelThreshold2 / 6);
+
+	return density;
 }
 
-INLINE Block blockAt(Column &c, int locX, int locY, int x, int y, int z) {
+// full tunnel density without early outs, used on the coarse lattice;
+// below tunnelThreshold2 means carved
+INLINE float tunnelDensity(dcs::DrvGenerator &gen1, dcs::DrvGenerator &gen2, int z) {
+
+	float z1 = z * tunnelScaleZ;
+	float z2 = z1 + simplexSamplingOffset;
+
+	std::array<float, 4> dx1;
+	gen1.sampleDrv(dx1, z1);
+	std::array<float, 4> dx2;
+	gen2.sampleDrv(dx2, z2);
+
+	return tunnelDensity(dx1, dx2, z);
+}
+
+#ifdef FIXED_NOISE
+
+using TunnelGenerator = dcs::DrvGeneratorFixed;
+
+constexpr s32 fixedTunnelScaleZ = dcs::toFixed(tunnelScaleZ);
+constexpr s32 fixedSamplingOffset = dcs::toFixed(simplexSamplingOffset);
+constexpr s64 fixedThreshold2 = (s64)dcs::toFixed(tunnelThreshold) * dcs::toFixed(tunnelThreshold); // q40
+
+// same test as the float version; noise terms are compared as q40 squares
+INLINE bool isTunnel(dcs::DrvGeneratorFixed &gen1, dcs::DrvGeneratorFixed &gen2, int z) {
+
+	s32 z1 = z * fixedTunnelScaleZ;
+	s32 z2 = z1 + fixedSamplingOffset;
+
+	s32 noise1 = gen1.sample(z1);
+	s64 density = (s64)noise1 * noise1;
+	if (density >= fixedThreshold2)
+		return false;
+
+	s32 noise2 = gen2.sample(z2);
+	density += (s64)noise2 * noise2;
+	if (density >= fixedThreshold2)
+		return false;
+
+	std::array<s32, 4> dx1;
+	gen1.sampleDrv(dx1, z1);
+	std::array<s32, 4> dx2;
+	gen2.sampleDrv(dx2, z2);
+
+	// the closing ratio needs a division, and is only reached next to tunnels
+	float noiseDeltaMagSq1 = (float)((s64)dx1[1]*dx1[1] + (s64)dx1[2]*dx1[2] + (s64)dx1[3]*dx1[3]);
+	float noiseDeltaMagSq2 = (float)((s64)dx2[1]*dx2[1] + (s64)dx2[2]*dx2[2] + (s64)dx2[3]*dx2[3]);
+	float noiseDeltaDot = (float)((s64)dx1[1]*dx2[1] + (s64)dx1[2]*dx2[2] + (s64)dx1[3]*dx2[3]);
+
+	float sqNormDot = (noiseDeltaDot * noiseDeltaDot) / (noiseDeltaMagSq1 * noiseDeltaMagSq2);
+
+	density += (s64)((sqNormDot * sqNormDot) * (fixedThreshold2 * tunnelClosing));
+	if (density >= fixedThreshold2)
+		return false;
+
+	int belowCutoff = tunnelZeroCutoff - z;
+	if (belowCutoff > 0) {
+		density += belowCutoff * fixedThreshold2 / 6;
+		if (density >= fixedThreshold2)
+			return false;
+	}
+
+	return true;
+}
+
+INLINE float tunnelDensity(dcs::DrvGeneratorFixed &gen1, dcs::DrvGeneratorFixed &gen2, int z) {
+
+	s32 z1 = z * fixedTunnelScaleZ;
+	s32 z2 = z1 + fixedSamplingOffset;
+
+	std::array<s32, 4> f1, f2;
+	gen1.sampleDrv(f1, z1);
+	gen2.sampleDrv(f2, z2);
+
+	std::array<float, 4> dx1, dx2;
+	for (int i = 0; i < 4; ++i) {
+		dx1[i] = f1[i] * (1.0f / dcs::FIXED_ONE);
+		dx2[i] = f2[i] * (1.0f / dcs::FIXED_ONE);
+	}
+	return tunnelDensity(dx1, dx2, z);
+}
+
+// where the tests above sample the first or the second generator for block z
+INLINE s32 tunnelY(int z, bool second) {
+	s32 y = z * fixedTunnelScaleZ;
+	return second ? y + fixedSamplingOffset : y;
+}
+
+// about the last block sampled at or below y
+INLINE int tunnelBlock(s32 y, bool second) {
+	return ((s64)y - (second ? fixedSamplingOffset : 0)) / fixedTunnelScaleZ;
+}
+
+#else
+
+using TunnelGenerator = dcs::DrvGenerator;
+
+INLINE float tunnelY(int z, bool second) {
+	float y = z * tunnelScaleZ;
+	return second ? y + simplexSamplingOffset : y;
+}
+
+INLINE int tunnelBlock(float y, bool second) {
+	return (int)std::min((y - (second ? simplexSamplingOffset : 0)) / tunnelScaleZ, (float)INT32_MAX / 2);
+}
+
+#endif
+
+// the lowest block tunnels are tested at
+constexpr int tunnelBottom = -zChunks * chunkSize;
+
+// a tunnel generator walked up one block column. what a generator returns depends on
+// where its cell was computed, as float rounding differs with it, so that is not left to
+// where a run of tests starts: the first cell is computed at the bottom of the world and
+// each next one at the block above the last one the previous cell covers. the cell of a
+// block, and every value sampled for it, then depends on z alone, whether the column is
+// walked whole or one chunk at a time
+struct TunnelWalk {
+
+	TunnelGenerator gen;
+	bool second;
+	int cellEnd; // last block of the current cell
+
+	TunnelWalk(dcs::Seed const &seed, bool second): gen(seed), second(second) {}
+
+	void reset(int x, int y) {
+		gen.reset(x * tunnelScaleXY, y * tunnelScaleXY);
+		cellEnd = tunnelBottom - 1;
+	}
+
+	bool cached(int z) const {
+		return z <= cellEnd;
+	}
+
+	// moves to the cell of block z; z only goes up between resets
+	INLINE void seek(int z) {
+		while (z > cellEnd) {
+			int start = cellEnd + 1;
+			gen.moveTo(tunnelY(start, second));
+			auto top = gen.cellTop();
+			// a guess from the top of the cell, then exact against the samples themselves
+			cellEnd = std::max(start, tunnelBlock(top, second));
+			while (tunnelY(cellEnd + 1, second) <= top)
+				++cellEnd;
+			while (cellEnd > start && tunnelY(cellEnd, second) > top)
+				--cellEnd;
+		}
+	}
+};
+
+constexpr float oreScale = 0.1f;
+constexpr float oreThreshold = 0.75f;
+
+int densityLattice = 1;
+
+HeightLayer heightLayers[maxHeightLayers] = { { 0, 0.02f, 4.0f, 1 } };
+int heightLayerCount = 1;
+
+struct {
+	std::atomic<u32> columns;
+	std::atomic<u32> cellsReused;
+} columnJobStats;
+
+}
+
+std::vector<HeightLayer> worldgen::getHeightLayers() {
+	return { heightLayers, heightLayers + heightLayerCount };
+}
+
+void worldgen::setHeightLayers(std::vector<HeightLayer> const &layers) {
+	heightLayerCount = std::min<int>(layers.size(), maxHeightLayers);
+	for (int i = 0; i < heightLayerCount; ++i) {
+		auto l = layers[i];
+		int s = 1;
+		while (s < l.step && s < chunkSize)
+			s <<= 1;
+		l.step = s;
+		heightLayers[i] = l;
+	}
+	setColumnCacheBudget(getColumnCacheStats().budget);
+}
+
+u32 worldgen::getSettingsHash() {
+
+	u32 h = 0x811c9dc5;
+	auto add = [&](auto v) {
+		u32 bits;
+		static_assert(sizeof(v) == sizeof(bits));
+		memcpy(&bits, &v, sizeof(bits));
+		for (int i = 0; i < 4; ++i)
+			h = (h ^ ((bits >> i * 8) & 0xff)) * 0x01000193;
+	};
+
+	add(densityLattice);
+	add(heightLayerCount);
+	for (int i = 0; i < heightLayerCount; ++i) {
+		auto &l = heightLayers[i];
+		add(l.seed);
+		add(l.scale);
+		add(l.amplitude);
+		add(l.step);
+	}
+	return h;
+}
+
+int worldgen::getDensityLattice() {
+	return densityLattice;
+}
+
+void worldgen::setDensityLattice(int step) {
+	int s = 1;
+	while (s < step && s < chunkSize)
+		s <<= 1;
+	densityLattice = s;
+
+	pipeline.caves = s > 1 ? latticeCavesStage : exactCavesStage;
+	pipeline.ore = s > 1 ? latticeOreStage : exactOreStage;
+}
+
+Pipeline worldgen::getPipeline() {
+	return pipeline;
+}
+
+void worldgen::setPipeline(Pipeline const &p) {
+	pipeline = p;
+}
+
+std::array<StageStats, (int)Stage::Count> worldgen::getStageStats() {
+	std::array<StageStats, (int)Stage::Count> stats;
+	for (int i = 0; i < (int)Stage::Count; ++i)
+		stats[i] = { stageStats[i].calls.load(), stageStats[i].ticks.load() };
+	return stats;
+}
+
+void worldgen::resetStageStats() {
+	for (auto &s: stageStats) {
+		s.calls = 0;
+		s.ticks = 0;
+	}
+}
+
+namespace {
+
+constexpr int coarseSize = chunkSize / 2 + 1;
+
+// scratch for the heightmap, kept off the worker stack
+thread_local struct {
+	std::array<float, chunkSize * chunkSize> heights, layer;
+	std::array<float, coarseSize * coarseSize> xs, ys, coarse;
+} hm;
+
+// layer at lattice points (x0 + i * step, y0 + j * step) around the column, then
+// bilinear to every block; neighbours sample the same points on their shared edge
+void addCoarseLayer(HeightLayer const &l, int x0, int y0) {
+
+	int n = chunkSize / l.step + 1;
+	for (int j = 0; j < n; ++j)
+		for (int i = 0; i < n; ++i) {
+			hm.xs[i + j * n] = (x0 + i * l.step) * l.scale;
+			hm.ys[i + j * n] = (y0 + j * l.step) * l.scale;
+		}
+	noise2dBatch(l.seed, hm.xs.data(), hm.ys.data(), hm.coarse.data(), n * n);
+
+	float inv = 1.0f / l.step;
+	for (int ly = 0; ly < chunkSize; ++ly) {
+		int j = ly / l.step; float fy = (ly % l.step) * inv;
+		float const *c0 = &hm.coarse[j * n], *c1 = c0 + n;
+		for (int lx = 0; lx < chunkSize; ++lx) {
+			int i = lx / l.step; float fx = (lx % l.step) * inv;
+			float a = c0[i] + (c0[i + 1] - c0[i]) * fx;
+			float b = c1[i] + (c1[i + 1] - c1[i]) * fx;
+			hm.heights[lx + ly * chunkSize] += (a + (b - a) * fy) * l.amplitude;
+		}
+	}
+}
+
+}
+
+void worldgen::heightmapStage(Column &c, s16 cx, s16 cy) {
+
+	c.minHeight = std::numeric_limits<int>::max();
+	c.maxHeight = std::numeric_limits<int>::min();
+
+	auto &heights = hm.heights;
+	heights.fill(0);
+
+	for (int i = 0; i < heightLayerCount; ++i) {
+		auto &l = heightLayers[i];
+		if (l.step > 1) {
+			addCoarseLayer(l, cx * chunkSize, cy * chunkSize);
+			continue;
+		}
+		noise2dGrid(l.seed, cx * chunkSize, cy * chunkSize, l.scale, hm.layer.data());
+		for (int b = 0; b < chunkSize * chunkSize; ++b)
+			heights[b] += hm.layer[b] * l.amplitude;
+	}
+
+	// one draw per block decides all of its decoration; kept off the worker stack
+	thread_local std::array<u16, rng::columnSize> draws;
+	rng::column(decorationKey, cx * chunkSize, cy * chunkSize, draws.data());
+
+	for (int ly = 0; ly < chunkSize; ++ly)
+		for (int lx = 0; lx < chunkSize; ++lx) {
+
+			auto &b = c.blocks[ly][lx];
+			u32 r = draws[lx + ly * chunkSize];
+
+			b.height = heights[lx + ly * chunkSize] + chunkSize/2;
+
+			b.grass = ((r >> 7) & 0xf) == 0; // 1 in 16
+
+			b.tree = (r & 0x7f) == 5 ? 1 + (r >> 11) % treeVariants : 0; // 1 in 128
+
+			c.minHeight = std::min(c.minHeight, b.height);
+			c.maxHeight = std::max(c.maxHeight, b.height);
+		}
+}
+
+
+INLINE Block blockAt(Column &c, int locX, int locY, int z, bool ore) {
 
 	auto &cc = c.blocks[locY][locX];
 
@@ -128,9 +610,7 @@ INLINE Block blockAt(Column &c, int locX, int locY, int x, int y, int z) {
 			return { 0 };
 	} else {
 		if (z < cc.height - 3) { // 3 blocks below
-			const float sc = 0.1f;
-			float noise = noise3d(0, x*sc, y*sc, z*sc);
-			if (noise > 0.75f) // rather rare 3d noise
+			if (ore) // rather rare 3d noise
 				return Block::solid(8); // generate coal
 			else
 				return Block::solid(2); // generate stone
@@ -143,102 +623,399 @@ INLINE Block blockAt(Column &c, int locX, int locY, int x, int y, int z) {
 	}
 }
 
-void treeStamp(int x, int y, int z, stampList &softStamps, stampList &hardStamps) {
-
-	for (int lz = 0; lz < 2; ++lz)
-		for (int ly = -1; ly < 2; ++ly)
-			for (int lx = -1; lx < 2; ++lx)
-				if (lz != 2 || ly == 0 || lx == 0)
-					softStamps.add(x + lx, y + ly, 2 + z + lz, Block::solid(25));
-
-	const int branches = 5;
-	for (int i = 0; i < branches; ++i) {
-
-		auto h = simpleHash(x, y, z + i);
-		int bx = h & 0x3; if (bx > 2) bx = 2 - bx;
-		int by = (h >> 3) & 0x3; if (by > 2) by = 2 - by;
-		int bz = (h >> 6) & 0x3; if (bz == 3) bz = 0;
-
-		for (int lz = 0; lz < 2; ++lz)
-			for (int ly = -1; ly < 2; ++ly)
-				for (int lx = -1; lx < 2; ++lx)
-					if (lz != 2 || ly == 0 || lx == 0)
-						if (simpleHash(lz, ly, lx + i) & 0x3)
-							softStamps.add(bx + x + lx, by + y + ly, bz + 2 + z + lz, Block::solid(25));
-	}
-
-	for (int iz = 0; iz < 3; ++iz)
-		hardStamps.add(x, y, z + iz, Block::solid(24));
-}
-
-void generateTreeStamps(Column const &c, s16 offX, s16 offY, stampList &softStamps, stampList &hardStamps) {
+void generateTreePlacements(Column const &c, int offX, int offY, placementList &placements) {
 	for (int ly = 0; ly < chunkSize; ++ly)
 		for (int lx = 0; lx < chunkSize; ++lx) {
 			auto &b = c.blocks[ly][lx];
 			if (b.tree)
-				treeStamp(lx + offX, ly + offY, b.height, softStamps, hardStamps);
+				placements.add(lx + offX, ly + offY, b.height, structureTree + b.tree - 1);
 		}
 }
 
-// todo: stamps should be generated once per block
-void generateStamps(s16 cx, s16 cy, stampList &softStamps, stampList &hardStamps) {
+// decoration phase; trees can overhang from the 3x3 neighbourhood
+void decorateColumn(GenJob const &job) {
+	placementList placements;
 	for (int y = -1; y < 2; ++y)
 		for (int x = -1; x < 2; ++x) {
-			auto &column = getColumn(cx + x, cy + y);
-			generateTreeStamps(column, x*chunkSize, y*chunkSize, softStamps, hardStamps);
+			auto &c = *job.neighbours[(y + 1) * 3 + x + 1];
+			generateTreePlacements(c, x * chunkSize, y * chunkSize, placements);
 		}
+	placements.placements.shrink_to_fit();
+	publishPlacements(job.cx, job.cy, placements);
 }
 
-void placeStamps(chunk &data, int offZ, stampList &softStamps, stampList &hardStamps) {
-	for (auto [x, y, z, block]: hardStamps.stamps) {
-		z += offZ;
-		if (z >= 0 && z < chunkSize)
-			data[z][y][x] = block;
+// copies the rows of a structure that fall inside the chunk
+template <bool soft>
+void blitStructure(chunk &data, int offZ, placement const &p) {
+
+	auto &s = structures[p.structure];
+	int x0 = p.x - s.rootX, y0 = p.y - s.rootY, z0 = p.z + offZ - s.rootZ;
+
+	int sx0 = std::max(0, -x0), sx1 = std::min<int>(s.w, chunkSize - x0);
+	int sy0 = std::max(0, -y0), sy1 = std::min<int>(s.d, chunkSize - y0);
+	int sz0 = std::max(0, -z0), sz1 = std::min<int>(s.h, chunkSize - z0);
+
+	Block const *cells = soft ? s.soft : s.hard;
+
+	for (int sz = sz0; sz < sz1; ++sz)
+		for (int sy = sy0; sy < sy1; ++sy) {
+			Block const *src = cells + (sz * s.d + sy) * s.w;
+			auto &dst = data[z0 + sz][y0 + sy];
+			for (int sx = sx0; sx < sx1; ++sx)
+				if (!src[sx].isAir() && (!soft || dst[x0 + sx].isAir()))
+					dst[x0 + sx] = src[sx];
+		}
+}
+
+// hard cells of every structure go first, so the order of placements does not matter
+void placeStructures(chunk &data, int offZ, placementList const &placements) {
+
+	if (!placements.overlaps(-offZ, -offZ + chunkSize))
+		return;
+
+	for (auto &p: placements.placements)
+		blitStructure<false>(data, offZ, p);
+	for (auto &p: placements.placements)
+		blitStructure<true>(data, offZ, p);
+}
+
+ColumnJobStats worldgen::getColumnJobStats() {
+	return { columnJobStats.columns.load(), columnJobStats.cellsReused.load() };
+}
+
+ColumnCacheStats worldgen::getColumnCacheStats() {
+	ColumnCacheStats stats;
+	for (auto &shard: cache) {
+		LightLock_Lock(&shard.lock);
+		stats.hits += shard.stats.hits;
+		stats.misses += shard.stats.misses;
+		stats.evictions += shard.stats.evictions;
+		stats.size += shard.slots.size();
+		stats.budget += shard.budget;
+		LightLock_Unlock(&shard.lock);
 	}
+	return stats;
+}
 
-	for (auto [x, y, z, block]: softStamps.stamps) {
-		z += offZ;
-		if (z >= 0 && z < chunkSize)
-			if (data[z][y][x].isAir())
-				data[z][y][x] = block;
+void worldgen::setColumnCacheBudget(int columns) {
+	if (columns < minColumnCacheBudget)
+		columns = minColumnCacheBudget;
+	if (columns >= noSlot)
+		columns = noSlot - 1;
+
+	for (auto &shard: cache) {
+		LightLock_Lock(&shard.lock);
+		shard.index.clear();
+		shard.slots.clear();
+		shard.head = shard.tail = noSlot;
+		shard.budget = (columns + columnCacheShards - 1) / columnCacheShards;
+		LightLock_Unlock(&shard.lock);
 	}
 }
 
-chunk *generateChunk(s16 cx, s16 cy, s16 cz) {
+// drop the block array if generation ended up with a single value
+ChunkBlocks compactChunk(chunk *data) {
+	auto first = (*data)[0][0][0];
+	for (auto &layer: *data)
+		for (auto &row: layer)
+			for (auto b: row)
+				if (b.value != first.value)
+					return { data, { 0 } };
+
+	releaseChunk(data);
+	return { nullptr, first };
+}
+
 
-    auto data = new chunk();
-	int x = (int)cx << chunkBits; int y = (int)cy << chunkBits; int z = (int)cz << chunkBits;
+INLINE int chunkZ(GenJob const &job, int i) {
+	return (job.cz0 + i) * chunkSize;
+}
 
-	auto &column = getColumn(cx, cy);
+void worldgen::exactCavesStage(GenJob &job) {
 
-	dcs::DrvGenerator gen1(n1);
-	dcs::DrvGenerator gen2(n2);
+	auto &column = *job.column;
+	int x = (int)job.cx << chunkBits; int y = (int)job.cy << chunkBits;
+
+	for (int i = 0; i < job.count; ++i)
+		job.carved[i] = {};
+
+	TunnelWalk walk1(n1, false);
+	TunnelWalk walk2(n2, true);
+
+	u32 cellsReused = 0;
 
 	for (int lx = 0; lx < chunkSize; ++lx)
 		for (int ly = 0; ly < chunkSize; ++ly) {
 			int _x = x + lx; int _y = y + ly;
+			int height = column.blocks[ly][lx].height;
+
+			// one walk per block column, up through every chunk of the job
+			walk1.reset(_x, _y);
+			walk2.reset(_x, _y);
 
-			gen1.reset(_x * tunnelScaleXY, _y * tunnelScaleXY);
-			gen2.reset(_x * tunnelScaleXY, _y * tunnelScaleXY);
+			for (int i = 0; i < job.count; ++i) {
 
-			for (int lz = 0; lz < chunkSize; ++lz) {
+				int z = chunkZ(job, i);
 
-				int _z = z + lz;
+				if (!job.data[i])
+					continue;
 
-				if (isTunnel(gen1, gen2, _z))
-					(*data)[lz][ly][lx] = { 0 };
+				// tunnels only turn blocks into air, so nothing above the grass layer needs the test
+				int carveEnd = std::min(chunkSize, height - z + 1);
+				if (carveEnd <= 0)
+					continue;
 
-				else {
-					auto block = blockAt(column, lx, ly, _x, _y, _z);
-					(*data)[lz][ly][lx] = block;
+				// a single chunk would walk up to here from the bottom of the world
+				if (i > 0)
+					cellsReused += walk1.cached(z) + walk2.cached(z);
+
+				for (int lz = 0; lz < carveEnd; ++lz) {
+					walk1.seek(z + lz);
+					walk2.seek(z + lz);
+					if (isTunnel(walk1.gen, walk2.gen, z + lz))
+						job.carved[i][lz][ly] |= 1 << lx;
 				}
 			}
 		}
 
-	if (!column.stampsGenerated)
-		generateStamps(cx, cy, column.softStamps, column.hardStamps);
+	columnJobStats.cellsReused.fetch_add(cellsReused, std::memory_order_relaxed);
+}
+
+void worldgen::exactOreStage(GenJob &job) {
+
+	auto &column = *job.column;
+	int x = (int)job.cx << chunkBits; int y = (int)job.cy << chunkBits;
+
+	for (int i = 0; i < job.count; ++i)
+		job.ore[i] = {};
+
+	for (int lx = 0; lx < chunkSize; ++lx)
+		for (int ly = 0; ly < chunkSize; ++ly) {
+			int height = column.blocks[ly][lx].height;
+
+			for (int i = 0; i < job.count; ++i) {
+
+				if (!job.data[i])
+					continue;
+
+				// ore is only ever sampled 3 blocks below the surface
+				int z = chunkZ(job, i);
+				int count = std::clamp(height - 3 - z, 0, chunkSize);
+				if (!count)
+					continue;
+
+				std::array<float, chunkSize> ore;
+				noise3dRun(0, x + lx, y + ly, z, oreScale, ore.data(), count);
+
+				for (int lz = 0; lz < count; ++lz)
+					if (ore[lz] > oreThreshold)
+						job.ore[i][lz][ly] |= 1 << lx;
+			}
+		}
+}
+
+namespace {
+
+constexpr int maxLatticePoints = chunkSize + 1;
+using lattice = std::array<std::array<std::array<float, maxLatticePoints>, maxLatticePoints>, maxLatticePoints>;
+
+thread_local lattice latticeValues;
+
+// densities sampled every `step` blocks, including the far chunk border
+// so that neighbouring chunks line up
+template <typename Density>
+void fillLattice(int x, int y, int z, int step, Density density) {
+
+	int points = chunkSize / step + 1;
+
+	for (int i = 0; i < points; ++i)
+		for (int j = 0; j < points; ++j)
+			for (int k = 0; k < points; ++k)
+				latticeValues[k][j][i] = density(x + i * step, y + j * step, z + k * step, k == 0);
+}
+
+INLINE float sampleLattice(int lx, int ly, int lz, int step, float invStep) {
+
+	auto &l = latticeValues;
+
+	int i = lx / step, j = ly / step, k = lz / step;
+	float fx = (lx - i * step) * invStep;
+	float fy = (ly - j * step) * invStep;
+	float fz = (lz - k * step) * invStep;
+
+	float c00 = l[k][j][i] + (l[k][j][i+1] - l[k][j][i]) * fx;
+	float c10 = l[k][j+1][i] + (l[k][j+1][i+1] - l[k][j+1][i]) * fx;
+	float c01 = l[k+1][j][i] + (l[k+1][j][i+1] - l[k+1][j][i]) * fx;
+	float c11 = l[k+1][j+1][i] + (l[k+1][j+1][i+1] - l[k+1][j+1][i]) * fx;
+
+	float c0 = c00 + (c10 - c00) * fy;
+	float c1 = c01 + (c11 - c01) * fy;
+	return c0 + (c1 - c0) * fz;
+}
+
+}
+
+// cave density sampled on the lattice and trilinearly interpolated
+void worldgen::latticeCavesStage(GenJob &job) {
+
+	int x = (int)job.cx << chunkBits; int y = (int)job.cy << chunkBits;
+	int step = densityLattice;
+	float invStep = 1.0f / step;
+
+	TunnelWalk walk1(n1, false);
+	TunnelWalk walk2(n2, true);
+
+	for (int i = 0; i < job.count; ++i) {
+
+		job.carved[i] = {};
+		if (!job.data[i])
+			continue;
+
+		int z = chunkZ(job, i);
+
+		fillLattice(x, y, z, step, [&](int _x, int _y, int _z, bool newColumn) {
+			if (newColumn) {
+				walk1.reset(_x, _y);
+				walk2.reset(_x, _y);
+			}
+			walk1.seek(_z);
+			walk2.seek(_z);
+			return tunnelDensity(walk1.gen, walk2.gen, _z);
+		});
+
+		for (int lz = 0; lz < chunkSize; ++lz)
+			for (int ly = 0; ly < chunkSize; ++ly)
+				for (int lx = 0; lx < chunkSize; ++lx)
+					if (sampleLattice(lx, ly, lz, step, invStep) < tunnelThreshold2)
+						job.carved[i][lz][ly] |= 1 << lx;
+	}
+}
+
+void worldgen::latticeOreStage(GenJob &job) {
+
+	auto &column = *job.column;
+	int x = (int)job.cx << chunkBits; int y = (int)job.cy << chunkBits;
+	int step = densityLattice;
+	float invStep = 1.0f / step;
+
+	for (int i = 0; i < job.count; ++i) {
+
+		job.ore[i] = {};
+		int z = chunkZ(job, i);
+		if (!job.data[i] || z >= column.maxHeight - 3)
+			continue;
+
+		fillLattice(x, y, z, step, [](int _x, int _y, int _z, bool) {
+			return noise3d(0, _x*oreScale, _y*oreScale, _z*oreScale);
+		});
+
+		for (int ly = 0; ly < chunkSize; ++ly)
+			for (int lx = 0; lx < chunkSize; ++lx) {
+				int count = std::clamp(column.blocks[ly][lx].height - 3 - z, 0, chunkSize);
+				for (int lz = 0; lz < count; ++lz)
+					if (sampleLattice(lx, ly, lz, step, invStep) > oreThreshold)
+						job.ore[i][lz][ly] |= 1 << lx;
+			}
+	}
+}
+
+void worldgen::surfaceStage(GenJob &job) {
+
+	auto &column = *job.column;
+
+	for (int i = 0; i < job.count; ++i) {
+
+		if (!job.data[i])
+			continue;
+
+		auto &data = *job.data[i];
+		int z = chunkZ(job, i);
+
+		for (int lz = 0; lz < chunkSize; ++lz)
+			for (int ly = 0; ly < chunkSize; ++ly) {
+				u16 carved = job.carved[i][lz][ly];
+				u16 ore = job.ore[i][lz][ly];
+				for (int lx = 0; lx < chunkSize; ++lx)
+					data[lz][ly][lx] = (carved >> lx) & 1 ?
+						Block { 0 } :
+						blockAt(column, lx, ly, z + lz, (ore >> lx) & 1);
+			}
+	}
+}
+
+void worldgen::decorationStage(GenJob &job) {
+
+	auto &column = *job.column;
+
+	if (job.neighbours[4])
+		decorateColumn(job);
+
+	for (int i = 0; i < job.count; ++i) {
+
+		int z = chunkZ(job, i);
+
+		// a tree reaching into the air above the terrain
+		if (!job.data[i]) {
+			if (!column.placements.overlaps(z, z + chunkSize))
+				continue;
+			job.data[i] = createChunk(true);
+		}
+
+		placeStructures(*job.data[i], -z, column.placements);
+	}
+}
+
+namespace {
+
+// scratch for the job in flight, one per thread; too large for the worker stack
+thread_local GenJob job;
+
+}
+
+void runPipeline(s16 cx, s16 cy, s16 cz0, int count, ChunkBlocks *out) {
+
+	auto &slot = pinColumn(cx, cy);
+	auto &column = slot.column;
+
+	// decoration looks at the 3x3 neighbourhood; pin it here so that
+	// its heightmaps are not timed as decoration
+	std::array<CacheSlot *, 9> neighbours { nullptr };
+	if (!hasPlacements(slot))
+		for (int y = -1; y < 2; ++y)
+			for (int x = -1; x < 2; ++x)
+				neighbours[(y + 1) * 3 + x + 1] = &pinColumn(cx + x, cy + y);
+
+	job.cx = cx; job.cy = cy; job.cz0 = cz0;
+	job.count = count;
+	job.column = &column;
+	for (int i = 0; i < 9; ++i)
+		job.neighbours[i] = neighbours[i] ? &neighbours[i]->column : nullptr;
+
+	// chunks above the terrain are plain air unless decoration says otherwise
+	for (int i = 0; i < count; ++i)
+		job.data[i] = chunkZ(job, i) <= column.maxHeight ? createChunk(true) : nullptr;
+
+	runStage(Stage::Caves, pipeline.caves, job);
+	runStage(Stage::Ore, pipeline.ore, job);
+	runStage(Stage::Surface, pipeline.surface, job);
+	runStage(Stage::Decoration, pipeline.decoration, job);
+
+	for (int i = 0; i < count; ++i)
+		out[i] = job.data[i] ? compactChunk(job.data[i]) : ChunkBlocks { nullptr, { 0 } };
+
+	for (auto *n: neighbours)
+		if (n)
+			unpinColumn(*n);
+	unpinColumn(slot);
+}
 
-	placeStamps(*data, -cz * chunkSize, column.softStamps, column.hardStamps);
+ChunkBlocks generateChunk(s16 cx, s16 cy, s16 cz) {
+	ChunkBlocks out;
+	runPipeline(cx, cy, cz, 1, &out);
+	return out;
+}
 
-	return data;
+void generateColumnChunks(s16 cx, s16 cy, std::array<ChunkBlocks, columnChunks> &out) {
+	runPipeline(cx, cy, -zChunks, columnChunks, out.data());
+	columnJobStats.columns.fetch_add(1, std::memory_order_relaxed);
 }
@@ -1,39 +1,182 @@
 #pragma once
 #include "common.hpp"
+#include "structures.hpp"
 
-// NOTE: worldgen is exclusively for the worker thread
+// generation can run on any number of threads at once; the setters
+// below are the exception and need every generating thread idle
 
 namespace worldgen {
 
 struct BlockColumn {
     int height;
     bool grass;
-    u8 tree;
+    u8 tree; // tree variant + 1, 0 for none
 };
 
-using stamp = std::tuple<s16, s16, int, Block>;
+// structure rooted at x, y local to the column (possibly in a neighbour) and world z
+struct placement {
+	s8 x, y;
+	s16 z;
+	u8 structure;
+};
+
+struct placementList {
+	std::vector<placement> placements;
+	s16 minZ = 0x7fff, maxZ = -0x8000;
 
-struct stampList {
-	std::vector<stamp> stamps;
-	void add(int x, int y, int z, Block block) {
-		if (x >= 0 && y >= 0 && x < chunkSize && y < chunkSize)
-			stamps.push_back({ (s16)x, (s16)y, z, block });
+	// only kept if some of the structure box lands in the column
+	void add(int x, int y, int z, u8 structure) {
+		auto &s = structures[structure];
+		int x0 = x - s.rootX, y0 = y - s.rootY, z0 = z - s.rootZ;
+		if (x0 + s.w > 0 && y0 + s.d > 0 && x0 < chunkSize && y0 < chunkSize) {
+			placements.push_back({ (s8)x, (s8)y, (s16)z, structure });
+			if (z0 < minZ) minZ = z0;
+			if (z0 + s.h - 1 > maxZ) maxZ = z0 + s.h - 1;
+		}
+	}
+	void clear() {
+		placements.clear();
+		minZ = 0x7fff; maxZ = -0x8000;
+	}
+	// whether any structure box reaches into the given world z range
+	bool overlaps(int z0, int z1) const {
+		return minZ < z1 && maxZ >= z0;
 	}
 };
 
 struct Column {
 
     std::array<std::array<BlockColumn, chunkSize>, chunkSize> blocks;
+    int minHeight, maxHeight;
     // u32 cacheIndex;
-    stampList softStamps;
-    stampList hardStamps;
-    bool stampsGenerated;
+    // decoration of this column, including trees rooted in its neighbours;
+    // generated once and shared by all vertical chunks
+    placementList placements;
+    bool placementsGenerated;
+};
+
+// columns kept around for heightmap and placement lookups; has to hold
+// at least the 3x3 neighbourhood used while generating a single chunk
+constexpr int defaultColumnCacheBudget = 16 * 16;
+constexpr int minColumnCacheBudget = 16;
+constexpr int columnCacheShards = 4;
+
+struct ColumnCacheStats {
+	u32 hits = 0;
+	u32 misses = 0;
+	u32 evictions = 0;
+	int size = 0;
+	int budget = 0;
+};
+
+ColumnCacheStats getColumnCacheStats();
+
+// drops all cached columns; only call while no chunk is being generated
+void setColumnCacheBudget(int columns);
+
+// spacing of the cave and ore density lattice, rounded up to a power of two;
+// 1 samples every block exactly, larger steps interpolate and trade accuracy for speed.
+// switches the caves and ore stages between the exact and lattice versions
+int getDensityLattice();
+void setDensityLattice(int step);
+
+// terrain height is the sum of 2d noise octaves; low frequencies can be sampled on a
+// coarse lattice aligned to world coordinates and bilinearly upsampled per block
+struct HeightLayer {
+	int seed;
+	float scale; // noise frequency per block
+	float amplitude; // in blocks
+	int step = 1; // lattice spacing, a power of two up to a chunk; 1 samples every block
+};
+
+constexpr int maxHeightLayers = 8;
+
+// the stock terrain is a single per-block octave; drops all cached columns,
+// so only call while no chunk is being generated
+std::vector<HeightLayer> getHeightLayers();
+void setHeightLayers(std::vector<HeightLayer> const &layers);
+
+// hash of the settings above that change the generated blocks, the density lattice
+// and the height layers; stored with pregenerated chunks to tell if they still match
+u32 getSettingsHash();
+
+struct ColumnJobStats {
+	u32 columns = 0;
+	// tunnel generator cells carried over a chunk boundary; generating the chunk
+	// on its own would have walked its generators up to it from the bottom
+	u32 cellsReused = 0;
 };
 
+ColumnJobStats getColumnJobStats();
+
+constexpr int columnChunks = zChunks * 2 + 1;
+
+// one bit per block, [z][y] with x as the bit index
+using ChunkMask = std::array<std::array<u16, chunkSize>, chunkSize>;
+
+// a vertical run of chunks from one column, passed through the pipeline together
+struct GenJob {
+	s16 cx, cy;
+	s16 cz0; // lowest chunk
+	int count;
+	Column *column;
+	// 3x3 neighbourhood as [y + 1][x + 1], only set while the column still needs its placements
+	std::array<Column const *, 9> neighbours;
+	// null where the chunk has no terrain; decoration may still allocate it
+	std::array<chunk *, columnChunks> data;
+	std::array<ChunkMask, columnChunks> carved;
+	std::array<ChunkMask, columnChunks> ore;
+};
+
+enum class Stage: u8 {
+	Heightmap,
+	Caves,
+	Ore,
+	Surface,
+	Decoration,
+	Count
+};
+
+// generation stages in the order they run; each can be replaced on its own
+struct Pipeline {
+	void (*heightmap)(Column &column, s16 cx, s16 cy);
+	void (*caves)(GenJob &job); // fills carved for chunks with data
+	void (*ore)(GenJob &job); // fills ore, only read below the dirt layer
+	void (*surface)(GenJob &job); // writes blocks from the heights and both masks
+	void (*decoration)(GenJob &job); // structures, may allocate chunks above the terrain
+};
+
+void heightmapStage(Column &column, s16 cx, s16 cy);
+void exactCavesStage(GenJob &job);
+void latticeCavesStage(GenJob &job);
+void exactOreStage(GenJob &job);
+void latticeOreStage(GenJob &job);
+void surfaceStage(GenJob &job);
+void decorationStage(GenJob &job);
+
+// only call while no chunk is being generated; cached columns keep their heightmap
+Pipeline getPipeline();
+void setPipeline(Pipeline const &pipeline);
+
+// time in system ticks, calls once per job (heightmap: per column)
+struct StageStats {
+	u32 calls = 0;
+	u64 ticks = 0;
+};
+
+std::array<StageStats, (int)Stage::Count> getStageStats();
+void resetStageStats();
+
 }
 
 // worldgen::Column &getColumn(s16 x, s16 y);
 
 Block blockAt(int x, int y, int z);
 
-chunk *generateChunk(s16 cx, s16 cy, s16 cz);
\ No newline at end of file
+ChunkBlocks generateChunk(s16 cx, s16 cy, s16 cz);
+
+using worldgen::columnChunks;
+
+// all chunks of a column in one pass, bottom first; the same blocks as generateChunk
+// on each of them
+void generateColumnChunks(s16 cx, s16 cy, std::array<ChunkBlocks, columnChunks> &out);
\ No newline at end of file
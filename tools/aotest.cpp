@@ -0,0 +1,127 @@
+// meshes gathered from the 26 neighbours against meshes of the same terrain cut
+// straight out of one contiguous volume; they have to match vertex for vertex
+// usage: aotest [columns to test]
+
+#include "mesher.hpp"
+#include "worldgen.hpp"
+
+#include <cstdlib>
+
+constexpr int span = chunkSize * 3; // 3x3 columns around the tested one
+constexpr int height = chunkSize * columnChunks;
+
+// [z][y][x], world z shifted so the bottom chunk starts at 0
+using Volume = std::array<std::array<std::array<Block, span>, span>, height>;
+
+struct Mesh {
+	std::vector<vertex> vertices;
+	std::vector<u16> indices;
+	std::vector<MesherAllocation::Mesh> meshes;
+};
+
+Mesh mesh(expandedChunk const &ex) {
+	auto a = meshChunk(ex);
+	Mesh m;
+	auto *v = static_cast<vertex *>(a.vertices);
+	m.vertices.assign(v, v + a.vertexCount);
+	int indices = 0;
+	for (auto &sub: a.meshes)
+		indices += sub.count;
+	auto *i = static_cast<u16 *>(a.indices);
+	m.indices.assign(i, i + indices);
+	m.meshes = a.meshes;
+	freeMesh(a);
+	return m;
+}
+
+bool same(Mesh const &a, Mesh const &b) {
+	if (a.vertices.size() != b.vertices.size() || a.indices != b.indices || a.meshes.size() != b.meshes.size())
+		return false;
+	for (size_t i = 0; i < a.meshes.size(); ++i)
+		if (a.meshes[i].count != b.meshes[i].count || a.meshes[i].texture != b.meshes[i].texture)
+			return false;
+	return !memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(vertex));
+}
+
+int main(int argc, char **argv) {
+
+	int tests = argc > 1 ? atoi(argv[1]) : 16;
+
+	static Volume volume;
+	static expandedChunk reference, gathered;
+	std::array<std::array<ChunkBlocks, columnChunks>, 9> columns;
+
+	int chunks = 0, failed = 0, vertices = 0, borderAo = 0;
+
+	for (int t = 0; t < tests; ++t) {
+
+		int cx = (t % 4) * 5 - 7, cy = (t / 4) * 5 - 7;
+
+		for (int c = 0; c < 9; ++c) {
+			auto &col = columns[c];
+			generateColumnChunks(cx + c % 3 - 1, cy + c / 3 - 1, col);
+			for (int i = 0; i < columnChunks; ++i) {
+				// every other chunk paletted, so both layouts meet at the borders
+				if ((i + c) & 1)
+					col[i].pack();
+				for (int z = 0; z < chunkSize; ++z)
+					for (int y = 0; y < chunkSize; ++y)
+						col[i].getRow(y, z, &volume[i * chunkSize + z][(c / 3) * chunkSize + y][(c % 3) * chunkSize]);
+			}
+		}
+
+		for (int i = 0; i < columnChunks; ++i) {
+
+			ChunkNeighbourhood n;
+			for (int dz = -1; dz < 2; ++dz)
+				for (int dy = -1; dy < 2; ++dy)
+					for (int dx = -1; dx < 2; ++dx) {
+						int ci = i + dz;
+						n[neighbourIndex(dx, dy, dz)] = ci < 0 || ci >= columnChunks ?
+							nullptr : &columns[(dy + 1) * 3 + dx + 1][ci];
+					}
+			auto *snapshot = takeSnapshot(n, MeshSegments().set());
+			expandSnapshot(*snapshot, gathered);
+			releaseSnapshot(snapshot);
+
+			// one block around the chunk, air past the top and bottom
+			for (int z = 0; z < chunkSize + 2; ++z)
+				for (int y = 0; y < chunkSize + 2; ++y)
+					for (int x = 0; x < chunkSize + 2; ++x) {
+						int vz = i * chunkSize + z - 1;
+						reference[z][y][x] = vz < 0 || vz >= height ?
+							Block { 0 } : volume[vz][chunkSize + y - 1][chunkSize + x - 1];
+					}
+
+			auto expected = mesh(reference);
+			auto actual = mesh(gathered);
+			++chunks;
+			vertices += expected.vertices.size();
+			if (!same(expected, actual)) {
+				++failed;
+				printf("mismatch in column %d %d chunk %d\n", cx, cy, i);
+			}
+
+			// what the old face-only gather left in: air on the 12 edges and 8 corners
+			for (int z = 0; z < chunkSize + 2; ++z)
+				for (int y = 0; y < chunkSize + 2; ++y)
+					for (int x = 0; x < chunkSize + 2; ++x) {
+						int outside = (x == 0 || x == chunkSize + 1) + (y == 0 || y == chunkSize + 1) +
+							(z == 0 || z == chunkSize + 1);
+						if (outside > 1)
+							reference[z][y][x] = { 0 };
+					}
+			auto faceOnly = mesh(reference);
+			for (size_t v = 0; v < faceOnly.vertices.size(); ++v)
+				borderAo += faceOnly.vertices[v].ao != expected.vertices[v].ao;
+		}
+
+		for (auto &col: columns)
+			for (auto &c: col)
+				c.release();
+	}
+
+	printf("%d chunks, %d vertices, %d meshes differ from the reference\n", chunks, vertices, failed);
+	printf("face-only gather had %d vertices with wrong ambient occlusion\n", borderAo);
+	return failed != 0;
+}
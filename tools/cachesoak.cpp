@@ -0,0 +1,131 @@
+// walks a few thousand columns through the column cache at several budgets, single
+// chunks and whole columns mixed, and checks after every step that the cache is within
+// its budget. every chunk is compared against a run with a cache large enough to never
+// evict, so a pinned column evicted under a job shows up as a changed chunk. a second
+// pass has several threads walking at once, which is when shards go over budget
+// usage: cachesoak [steps] [threads]
+
+#include "worldgen.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+u64 hashChunk(ChunkBlocks const &c) {
+	u64 h = 0xcbf29ce484222325;
+	for (int z = 0; z < chunkSize; ++z)
+		for (int y = 0; y < chunkSize; ++y)
+			for (int x = 0; x < chunkSize; ++x)
+				h = (h ^ c.get(x, y, z).value) * 0x100000001b3;
+	return h;
+}
+
+// a chunk, or a whole column when cz is columnChunks
+struct Step {
+	s16 cx, cy, cz;
+};
+
+// mostly next door, with the odd jump far enough to miss the cache
+std::vector<Step> makeWalk(int steps, u32 seed) {
+	std::mt19937 rng(seed);
+	std::vector<Step> walk;
+	s16 x = 0, y = 0;
+	for (int i = 0; i < steps; ++i) {
+		int r = rng() % 64;
+		if (r == 0) {
+			x = rng() % 400 - 200;
+			y = rng() % 400 - 200;
+		} else if (r < 32)
+			x += r & 1 ? 1 : -1;
+		else
+			y += r & 1 ? 1 : -1;
+		s16 z = rng() % 4 ? rng() % columnChunks - zChunks : columnChunks;
+		walk.push_back({ x, y, z });
+	}
+	return walk;
+}
+
+// one hash per step, a column's chunks hashed together; steps where the cache is over
+// budget are counted when asked, which only makes sense with one thread walking
+void run(std::vector<Step> const &walk, std::vector<u64> &hashes, int *overBudget) {
+	std::array<ChunkBlocks, columnChunks> column;
+	for (auto &s: walk) {
+		if (s.cz == columnChunks) {
+			generateColumnChunks(s.cx, s.cy, column);
+			u64 h = 0;
+			for (auto &c: column) {
+				h = h * 31 + hashChunk(c);
+				c.release();
+			}
+			hashes.push_back(h);
+		} else {
+			auto c = generateChunk(s.cx, s.cy, s.cz);
+			hashes.push_back(hashChunk(c));
+			c.release();
+		}
+		if (overBudget) {
+			auto stats = worldgen::getColumnCacheStats();
+			*overBudget += stats.size > stats.budget;
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+
+	int steps = argc > 1 ? atoi(argv[1]) : 3000;
+	int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+	std::vector<std::vector<Step>> walks;
+	for (int t = 0; t < threads; ++t)
+		walks.push_back(makeWalk(steps, t + 1));
+
+	// no evictions at all
+	std::vector<std::vector<u64>> reference(threads);
+	worldgen::setColumnCacheBudget(1 << 15);
+	for (int t = 0; t < threads; ++t)
+		run(walks[t], reference[t], nullptr);
+
+	int failed = 0;
+
+	for (int budget: { worldgen::minColumnCacheBudget, 64, worldgen::defaultColumnCacheBudget }) {
+
+		worldgen::setColumnCacheBudget(budget);
+		auto before = worldgen::getColumnCacheStats();
+
+		// a check after every step
+		int overBudget = 0;
+		std::vector<u64> hashes;
+		u64 start = svcGetSystemTick();
+		run(walks[0], hashes, &overBudget);
+		float single = (svcGetSystemTick() - start) * invTickRate;
+		int differ = 0;
+		for (int i = 0; i < steps; ++i)
+			differ += hashes[i] != reference[0][i];
+
+		auto stats = worldgen::getColumnCacheStats();
+		printf("budget %3d: %d steps in %.2f s, %u hits %u misses %u evictions, %d steps over budget, %d differ\n",
+			stats.budget, steps, single, stats.hits - before.hits, stats.misses - before.misses,
+			stats.evictions - before.evictions, overBudget, differ);
+		failed += overBudget + differ;
+
+		// shards overflow while pinned by the other threads; once all are done they have to be back
+		std::vector<std::vector<u64>> threadHashes(threads);
+		std::vector<std::thread> pool;
+		for (int t = 0; t < threads; ++t)
+			pool.emplace_back([&, t] { run(walks[t], threadHashes[t], nullptr); });
+		for (auto &th: pool)
+			th.join();
+
+		differ = 0;
+		for (int t = 0; t < threads; ++t)
+			for (int i = 0; i < steps; ++i)
+				differ += threadHashes[t][i] != reference[t][i];
+		stats = worldgen::getColumnCacheStats();
+		printf("  %d threads: %d columns cached after, %d differ\n", threads, stats.size, differ);
+		failed += (stats.size > stats.budget) + differ;
+	}
+
+	printf(failed ? "FAILED\n" : "ok\n");
+	return failed != 0;
+}
@@ -0,0 +1,192 @@
+// chunks the renderer would submit around a few camera spots, with and without the
+// connectivity walk, and what the flood fill and the walk cost. rays are cast from
+// each camera through the open blocks; every chunk one can see into has to be found,
+// also when some of the chunks around it are not resident yet
+// usage: cullbench [rays]
+
+#include "world.hpp"
+#include "worldgen.hpp"
+
+#include <random>
+
+constexpr int columnRange = renderDistance + 1;
+
+std::vector<s16vec3> resident;
+
+ChunkNeighbourhood gather(s16vec3 idx) {
+	ChunkNeighbourhood n { nullptr };
+	for (int dz = -1; dz < 2; ++dz)
+		for (int dy = -1; dy < 2; ++dy)
+			for (int dx = -1; dx < 2; ++dx)
+				if (auto *ch = tryGetChunk(idx.x + dx, idx.y + dy, idx.z + dz))
+					n[neighbourIndex(dx, dy, dz)] = &ch->blocks;
+	return n;
+}
+
+s16vec3 chunkOf(fvec3 p) {
+	return { (s16)(fastFloor(p.x) >> chunkBits), (s16)(fastFloor(p.y) >> chunkBits), (s16)(fastFloor(p.z) >> chunkBits) };
+}
+
+bool inRange(s16vec3 idx, s16vec3 camera) {
+	int dx = idx.x - camera.x, dy = idx.y - camera.y, dz = idx.z - camera.z;
+	return dx*dx + dy*dy + dz*dz <= renderDistance * renderDistance;
+}
+
+// chunks a ray from the eye passes through until it hits a solid block, that one's included;
+// walked in small steps, so it may clip the odd corner, which is still fine as a check
+void castRay(fvec3 eye, fvec3 dir, s16vec3 camera, std::vector<s16vec3> &seen) {
+	for (float t = 0; t < renderDistance * chunkSize; t += 0.05f) {
+		fvec3 p { eye.x + dir.x * t, eye.y + dir.y * t, eye.z + dir.z * t };
+		auto idx = chunkOf(p);
+		if (!inRange(idx, camera) || !tryGetChunk(idx.x, idx.y, idx.z))
+			return;
+		if (seen.empty() || !(seen.back() == idx))
+			seen.push_back(idx);
+		if (tryGetBlock(fastFloor(p.x), fastFloor(p.y), fastFloor(p.z)).isSolid())
+			return;
+	}
+}
+
+int main(int argc, char **argv) {
+
+	int rays = argc > 1 ? atoi(argv[1]) : 20000;
+
+	for (int cy = -columnRange; cy <= columnRange; ++cy)
+		for (int cx = -columnRange; cx <= columnRange; ++cx) {
+			std::array<ChunkBlocks, columnChunks> column;
+			generateColumnChunks(cx, cy, column);
+			for (int i = 0; i < columnChunks; ++i) {
+				column[i].pack();
+				s16vec3 idx { (s16)cx, (s16)cy, (s16)(i - zChunks) };
+				world.insert(idx)->blocks = column[i];
+				resident.push_back(idx);
+			}
+		}
+
+	u64 fillTicks = 0;
+	int closed = 0;
+	for (auto idx: resident) {
+		auto &meta = *tryGetChunk(idx.x, idx.y, idx.z);
+		u64 start = svcGetSystemTick();
+		meta.connectivity = getConnectivity(meta.blocks);
+		fillTicks += svcGetSystemTick() - start;
+		closed += meta.connectivity != allFacesConnected;
+	}
+	printf("%zu chunks, %d not open all through, flood fill %.1f us a chunk\n",
+		resident.size(), closed, fillTicks * invTickRate * 1e6f / resident.size());
+
+	static expandedChunk ex;
+	for (auto idx: resident) {
+		auto &meta = *tryGetChunk(idx.x, idx.y, idx.z);
+		expandChunk(gather(idx), ex);
+		meta.allocation = meshChunk(ex);
+		meta.meshed = true;
+	}
+
+	int surface = (zChunks + 1) * chunkSize - 1;
+	while (surface > -zChunks * chunkSize && !tryGetBlock(8, 8, surface).isSolid())
+		--surface;
+
+	// the first open block well below the surface, scanning out from the middle
+	fvec3 cave { 8.5f, 8.5f, surface - 15.5f };
+	for (int z = surface - 16, found = 0; z > -zChunks * chunkSize && !found; --z)
+		for (int y = -32; y < 32 && !found; ++y)
+			for (int x = -32; x < 32 && !found; ++x)
+				if (tryGetBlock(x, y, z).isNonSolid() && tryGetBlock(x, y, z + 1).isNonSolid()) {
+					cave = { x + 0.5f, y + 0.5f, z + 0.5f };
+					found = 1;
+				}
+
+	struct Spot {
+		char const *name;
+		fvec3 eye;
+	};
+	Spot spots[] = {
+		{ "above surface", { 8.5f, 8.5f, surface + 2.5f } },
+		{ "in rock", { 8.5f, 8.5f, surface - 15.5f } },
+		{ "in a cave", cave },
+		{ "bottom", { 8.5f, 8.5f, -zChunks * chunkSize + 1.5f } },
+	};
+
+	std::mt19937 rng(1);
+	std::normal_distribution<float> normal;
+	std::vector<WorldMap::Slot *> visible;
+	std::vector<s16vec3> seen;
+	int missed = 0;
+
+	for (auto &spot: spots) {
+
+		auto camera = chunkOf(spot.eye);
+
+		int submitted = 0;
+		for (auto idx: resident)
+			submitted += inRange(idx, camera) && tryGetChunk(idx.x, idx.y, idx.z)->allocation.vertexCount;
+
+		constexpr int walks = 100;
+		u64 start = svcGetSystemTick();
+		for (int i = 0; i < walks; ++i)
+			findVisibleChunks(camera, renderDistance, visible);
+		u64 walkTicks = svcGetSystemTick() - start;
+
+		int culledSubmitted = 0;
+		for (auto *slot: visible)
+			culledSubmitted += slot->value.allocation.vertexCount != 0;
+
+		int spotMissed = 0;
+		for (int r = 0; r < rays; ++r) {
+			fvec3 dir { normal(rng), normal(rng), normal(rng) };
+			float len = sqrtf(dir.x*dir.x + dir.y*dir.y + dir.z*dir.z);
+			dir = { dir.x / len, dir.y / len, dir.z / len };
+			seen.clear();
+			castRay(spot.eye, dir, camera, seen);
+			for (auto idx: seen)
+				if (std::find_if(visible.begin(), visible.end(), [&](auto *s) { return s->idx == idx; }) == visible.end()) {
+					++spotMissed;
+					break;
+				}
+		}
+		missed += spotMissed;
+
+		printf("%-15s submitted %3d -> %3d of %3zu reached, walk %.1f us, %d rays see a chunk not reached\n",
+			spot.name, submitted, culledSubmitted, visible.size(),
+			walkTicks * invTickRate * 1e6f / walks, spotMissed);
+	}
+
+	// chunks still loading: with every fourth one taken out, each chunk reached before
+	// that is still resident has to be reached through the gaps
+	int lost = 0;
+	std::vector<s16vec3> reached;
+	std::vector<WorldMap::Slot *> gaps;
+	for (auto &spot: spots) {
+
+		auto camera = chunkOf(spot.eye);
+		findVisibleChunks(camera, renderDistance, visible);
+		reached.clear();
+		for (auto *slot: visible)
+			reached.push_back(slot->idx);
+
+		gaps.clear();
+		for (auto &slot: world.slots)
+			if (slot.used && !(slot.idx == camera) && ((slot.idx.x * 7 + slot.idx.y * 3 + slot.idx.z) & 3) == 0) {
+				slot.used = false;
+				gaps.push_back(&slot);
+			}
+
+		findVisibleChunks(camera, renderDistance, visible);
+		for (auto idx: reached)
+			if (tryGetChunk(idx.x, idx.y, idx.z) &&
+				std::find_if(visible.begin(), visible.end(), [&](auto *s) { return s->idx == idx; }) == visible.end())
+				++lost;
+
+		for (auto *slot: gaps)
+			slot->used = true;
+	}
+	printf("with a quarter of the chunks missing, %d resident chunks are not reached\n", lost);
+
+	for (auto &slot: world.slots)
+		if (slot.used) {
+			freeMesh(slot.value.allocation);
+			slot.value.blocks.release();
+		}
+	return missed + lost != 0;
+}
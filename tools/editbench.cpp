@@ -0,0 +1,217 @@
+// a 64 block wide sphere carved out of the terrain, from the first write to the last
+// remeshed chunk, through the bulk edit, a list of blocks and one block at a time.
+// remeshes run here in place of the worker; every spliced mesh has to match a full one,
+// and no edited chunk may stay unpacked
+// usage: editbench [rounds]
+
+#include "edit.hpp"
+#include "worldgen.hpp"
+
+#include <random>
+
+constexpr int columnRange = 4; // columns -4 to 4 on x and y
+constexpr int sphereRadius = 32;
+constexpr vec3<s32> sphereCentre { 3, -5, 8 };
+
+std::vector<ChunkBlocks> pristine;
+std::vector<MesherAllocation> baseMeshes;
+std::vector<s16vec3> resident;
+
+ChunkNeighbourhood gather(s16vec3 idx) {
+	ChunkNeighbourhood n { nullptr };
+	for (int dz = -1; dz < 2; ++dz)
+		for (int dy = -1; dy < 2; ++dy)
+			for (int dx = -1; dx < 2; ++dx)
+				if (auto *ch = tryGetChunk(idx.x + dx, idx.y + dy, idx.z + dz))
+					n[neighbourIndex(dx, dy, dz)] = &ch->blocks;
+	return n;
+}
+
+int residentIndex(s16vec3 idx) {
+	return std::find(resident.begin(), resident.end(), idx) - resident.begin();
+}
+
+void reset() {
+	for (size_t i = 0; i < resident.size(); ++i) {
+		auto &meta = *tryGetChunk(resident[i].x, resident[i].y, resident[i].z);
+		meta.blocks.release();
+		meta.blocks = pristine[i].share();
+		meta.modified = false;
+		meta.dirty = {};
+	}
+	chunksToRemesh.clear();
+}
+
+bool same(MesherAllocation const &a, MesherAllocation const &b) {
+	if (a.vertexCount != b.vertexCount || a.meshes.size() != b.meshes.size())
+		return false;
+	int indices = 0;
+	for (size_t i = 0; i < a.meshes.size(); ++i) {
+		if (a.meshes[i].count != b.meshes[i].count || a.meshes[i].texture != b.meshes[i].texture)
+			return false;
+		indices += a.meshes[i].count;
+	}
+	return !memcmp(a.vertices, b.vertices, a.vertexCount * sizeof(vertex))
+		&& !memcmp(a.indices, b.indices, indices * sizeof(u16));
+}
+
+// what the worker and main thread do for each queued chunk; spliced meshes are
+// compared against full ones when asked
+int remesh(bool verify) {
+	static expandedChunk ex;
+	int failed = 0;
+	for (auto idx: chunksToRemesh) {
+		auto &meta = *tryGetChunk(idx.x, idx.y, idx.z);
+		expandChunk(gather(idx), ex);
+		auto patch = meshChunk(ex, dirtySegments(meta.dirty));
+		meta.dirty = {};
+		auto spliced = spliceMesh(baseMeshes[residentIndex(idx)], patch);
+		if (verify) {
+			auto full = meshChunk(ex);
+			failed += !same(full, spliced);
+			freeMesh(full);
+		}
+		freeMesh(patch);
+		freeMesh(spliced);
+	}
+	return failed;
+}
+
+// chunks the edit changed but did not queue would keep a stale mesh
+int missed() {
+	static expandedChunk ex;
+	int stale = 0;
+	for (size_t i = 0; i < resident.size(); ++i) {
+		auto idx = resident[i];
+		if (std::find(chunksToRemesh.begin(), chunksToRemesh.end(), idx) != chunksToRemesh.end())
+			continue;
+		expandChunk(gather(idx), ex);
+		auto full = meshChunk(ex);
+		stale += !same(full, baseMeshes[i]);
+		freeMesh(full);
+	}
+	return stale;
+}
+
+// edited chunks left as dense arrays where a palette would be smaller
+int leftDense() {
+	int dense = 0;
+	for (auto idx: resident) {
+		auto &b = tryGetChunk(idx.x, idx.y, idx.z)->blocks;
+		if (!b.dense)
+			continue;
+		auto *p = PalettedChunk::pack(*b.dense);
+		dense += p != nullptr;
+		PalettedChunk::release(p);
+	}
+	return dense;
+}
+
+std::vector<BlockEdit> sphereBlocks() {
+	std::vector<BlockEdit> blocks;
+	auto c = sphereCentre;
+	int r = sphereRadius;
+	for (int z = c.z - r; z <= c.z + r; ++z)
+		for (int y = c.y - r; y <= c.y + r; ++y)
+			for (int x = c.x - r; x <= c.x + r; ++x)
+				if ((x - c.x) * (x - c.x) + (y - c.y) * (y - c.y) + (z - c.z) * (z - c.z) <= r * r)
+					blocks.push_back({ x, y, z, { 0 } });
+	// in no particular order, as from an explosion
+	std::shuffle(blocks.begin(), blocks.end(), std::mt19937(1));
+	return blocks;
+}
+
+int main(int argc, char **argv) {
+
+	int rounds = argc > 1 ? atoi(argv[1]) : 10;
+
+	for (int cy = -columnRange; cy <= columnRange; ++cy)
+		for (int cx = -columnRange; cx <= columnRange; ++cx) {
+			std::array<ChunkBlocks, columnChunks> column;
+			generateColumnChunks(cx, cy, column);
+			for (int i = 0; i < columnChunks; ++i) {
+				column[i].pack();
+				s16vec3 idx { (s16)cx, (s16)cy, (s16)(i - zChunks) };
+				world.insert(idx)->blocks = column[i].share();
+				pristine.push_back(column[i]);
+				resident.push_back(idx);
+			}
+		}
+
+	static expandedChunk ex;
+	for (auto idx: resident) {
+		expandChunk(gather(idx), ex);
+		baseMeshes.push_back(meshChunk(ex));
+	}
+
+	auto blocks = sphereBlocks();
+	printf("%zu resident chunks, sphere of %zu blocks\n", resident.size(), blocks.size());
+
+	struct Mode {
+		char const *name;
+		void (*edit)(std::vector<BlockEdit> &);
+	};
+	Mode modes[] = {
+		{ "fillSphere", [](std::vector<BlockEdit> &) {
+			fillSphere(sphereCentre, sphereRadius, { 0 });
+		} },
+		{ "setBlocks", [](std::vector<BlockEdit> &b) {
+			auto list = b;
+			setBlocks(list);
+		} },
+		{ "setBlock each", [](std::vector<BlockEdit> &b) {
+			for (auto &e: b)
+				setBlock(e.x, e.y, e.z, e.block);
+		} },
+		// a block placed high in the sky of every column, into uniform air chunks
+		{ "setBlock sky", [](std::vector<BlockEdit> &) {
+			for (int y = -columnRange; y <= columnRange; ++y)
+				for (int x = -columnRange; x <= columnRange; ++x)
+					setBlock(x * chunkSize + 5, y * chunkSize + 7, (zChunks + 1) * chunkSize - 3, Block::solid(1));
+		} },
+	};
+
+	int failed = 0, leftUnpacked = 0;
+
+	for (auto &mode: modes) {
+
+		reset();
+		mode.edit(blocks);
+		int changed = 0;
+		for (auto idx: resident)
+			changed += tryGetChunk(idx.x, idx.y, idx.z)->modified;
+		size_t queued = chunksToRemesh.size();
+		int stale = missed();
+		int dense = leftDense();
+		failed += stale + remesh(true);
+		leftUnpacked += dense;
+
+		u64 editTicks = 0, remeshTicks = 0;
+		for (int i = 0; i < rounds; ++i) {
+			reset();
+			u64 start = svcGetSystemTick();
+			mode.edit(blocks);
+			u64 t1 = svcGetSystemTick();
+			remesh(false);
+			u64 t2 = svcGetSystemTick();
+			editTicks += t1 - start;
+			remeshTicks += t2 - t1;
+		}
+
+		float ms = invTickRate * 1e3f / rounds;
+		printf("%-14s %3d chunks changed, %3zu remeshes, %d stale, %d left dense; edit %6.2f ms + remesh %6.2f ms = %6.2f ms\n",
+			mode.name, changed, queued, stale, dense, editTicks * ms, remeshTicks * ms, (editTicks + remeshTicks) * ms);
+	}
+
+	printf("%d meshes differ from a full remesh, %d chunks left dense\n", failed, leftUnpacked);
+
+	reset();
+	for (auto &m: baseMeshes)
+		freeMesh(m);
+	for (auto &slot: world.slots)
+		if (slot.used)
+			slot.value.blocks.release();
+	for (auto &b: pristine)
+		b.release();
+	return failed + leftUnpacked != 0;
+}
@@ -0,0 +1,151 @@
+// the q20 heightmap and tunnel kernels against the float ones they port, over a large
+// area of the world: largest error, and fails past a bound. also times both; the host
+// has fast floats, so only the 3ds numbers say whether the fixed path pays off.
+// the tunnel noise has seams where two lattice vertices are equally close and either
+// one is picked; there the fixed kernel may land on the other side, so samples past the
+// bound are compared against the float kernel a hair to either side as well
+// usage: fxtest [columns on a side]
+
+#ifndef FIXED_NOISE
+#error fxtest needs the fixed-point kernels, build it with -DFIXED_NOISE
+#endif
+
+#include "common.hpp"
+#include "dcsimplex.hpp"
+#include "noise.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// noise is in -1..1, a heightmap layer scales it by its amplitude in blocks. far out the
+// float kernel's own rounding of the coordinates takes over, so the grid bound grows with
+// the float step there
+constexpr float maxGridError = 5e-4f;
+constexpr float gridUlps = 16;
+constexpr float maxTunnelError = 2e-4f;
+constexpr float maxGradientError = 3e-3f; // gradients reach about 7
+constexpr float seamNudge = 1e-5f;
+
+constexpr int worldHeight = (zChunks * 2 + 1) * chunkSize;
+constexpr float tunnelScaleXY = 1.0f / 48;
+constexpr float tunnelScaleZ = 1.0f / 32;
+constexpr float fixedScale = 1.0f / dcs::FIXED_ONE;
+
+// a fresh generator at the point itself, as the cached lattice of one walking down the
+// column is swapped at a slightly different height in fixed point, then to each side
+constexpr int nudges[7][3] = {
+	{ 0, 0, 0 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 },
+};
+
+// largest difference across value and gradient
+float drvDistance(std::array<s32, 4> const &fixed, std::array<float, 4> const &reference) {
+	float d = 0;
+	for (int i = 0; i < 4; ++i)
+		d = std::max(d, fabsf(fixed[i] * fixedScale - reference[i]));
+	return d;
+}
+
+int main(int argc, char **argv) {
+
+	int side = argc > 1 ? atoi(argv[1]) : 64;
+	int failed = 0;
+
+	// heightmap grids, a column apart, at a few layer scales; float is noise2d point by point
+	for (float scale: { 0.02f, 0.005f, 0.1f }) {
+		float maxError = 0;
+		int overBound = 0;
+		u64 floatTicks = 0, fixedTicks = 0;
+		float reference[noiseGridSize * noiseGridSize], grid[noiseGridSize * noiseGridSize];
+		for (int cy = -side / 2; cy < side / 2; ++cy)
+			for (int cx = -side / 2; cx < side / 2; ++cx) {
+				int x0 = cx * noiseGridSize * 61, y0 = cy * noiseGridSize * 61; // spread far out
+				u64 start = svcGetSystemTick();
+				for (int j = 0; j < noiseGridSize; ++j)
+					for (int i = 0; i < noiseGridSize; ++i)
+						reference[i + j * noiseGridSize] = noise2d(0, (x0 + i) * scale, (y0 + j) * scale);
+				u64 t1 = svcGetSystemTick();
+				noise2dGrid(0, x0, y0, scale, grid);
+				u64 t2 = svcGetSystemTick();
+				floatTicks += t1 - start;
+				fixedTicks += t2 - t1;
+				float far = std::max(abs(x0), abs(y0)) * scale + noiseGridSize * scale;
+				float bound = maxGridError + gridUlps * (nextafterf(far, INFINITY) - far);
+				for (int i = 0; i < noiseGridSize * noiseGridSize; ++i) {
+					maxError = std::max(maxError, fabsf(grid[i] - reference[i]));
+					overBound += fabsf(grid[i] - reference[i]) > bound;
+				}
+			}
+		int points = side * side * noiseGridSize * noiseGridSize;
+		printf("2d grid, scale %.3f: max error %.2e, %d points past the bound, float %.1f ns, fixed %.1f ns a point\n",
+			scale, maxError, overBound, floatTicks * invTickRate * 1e9f / points, fixedTicks * invTickRate * 1e9f / points);
+		failed += overBound;
+	}
+
+	// tunnel generators down every column of the world height, value and gradient
+	constexpr dcs::Seed seed(0);
+	dcs::DrvGenerator gen(seed);
+	dcs::DrvGeneratorFixed genFixed(seed);
+	std::vector<std::array<float, 4>> drv(worldHeight);
+	std::vector<std::array<s32, 4>> drvFixed(worldHeight);
+	std::vector<float> value(worldHeight);
+	std::vector<s32> valueFixed(worldHeight);
+
+	float maxValueError = 0, maxDrvError = 0;
+	int seams = 0;
+	u64 floatTicks = 0, fixedTicks = 0;
+	constexpr s32 fixedScaleZ = dcs::toFixed(tunnelScaleZ);
+
+	for (int y = -side / 2; y < side / 2; ++y)
+		for (int x = -side / 2; x < side / 2; ++x) {
+			float fx = x * 37 * tunnelScaleXY, fy = y * 37 * tunnelScaleXY;
+
+			u64 start = svcGetSystemTick();
+			gen.reset(fx, fy);
+			for (int z = 0; z < worldHeight; ++z) {
+				float fz = (z - zChunks * chunkSize) * tunnelScaleZ;
+				value[z] = gen.sample(fz);
+				gen.sampleDrv(drv[z], fz);
+			}
+			u64 t1 = svcGetSystemTick();
+			genFixed.reset(fx, fy);
+			for (int z = 0; z < worldHeight; ++z) {
+				s32 fz = (z - zChunks * chunkSize) * fixedScaleZ;
+				valueFixed[z] = genFixed.sample(fz);
+				genFixed.sampleDrv(drvFixed[z], fz);
+			}
+			u64 t2 = svcGetSystemTick();
+			floatTicks += t1 - start;
+			fixedTicks += t2 - t1;
+
+			for (int z = 0; z < worldHeight; ++z) {
+				float fz = (z - zChunks * chunkSize) * tunnelScaleZ;
+				float valueError = fabsf(valueFixed[z] * fixedScale - value[z]);
+				float drvError = drvDistance(drvFixed[z], drv[z]);
+				if (valueError > maxTunnelError || drvError > maxGradientError) {
+					// the closest of the float samples around it
+					++seams;
+					for (auto n: nudges) {
+						dcs::DrvGenerator nudged(seed);
+						nudged.reset(fx + n[0] * seamNudge, fy + n[1] * seamNudge);
+						std::array<float, 4> d;
+						nudged.sampleDrv(d, fz + n[2] * seamNudge);
+						if (drvDistance(drvFixed[z], d) < drvError) {
+							drvError = drvDistance(drvFixed[z], d);
+							valueError = fabsf(drvFixed[z][0] * fixedScale - d[0]);
+						}
+					}
+				}
+				maxValueError = std::max(maxValueError, valueError);
+				maxDrvError = std::max(maxDrvError, drvError);
+			}
+		}
+
+	int samples = side * side * worldHeight;
+	printf("tunnel generator: max error %.2e value, %.2e gradient, %d samples next to a seam; float %.1f ns, fixed %.1f ns a block\n",
+		maxValueError, maxDrvError, seams, floatTicks * invTickRate * 1e9f / samples, fixedTicks * invTickRate * 1e9f / samples);
+	failed += !(maxValueError <= maxTunnelError) + !(maxDrvError <= maxGradientError);
+
+	printf(failed ? "FAILED\n" : "ok\n");
+	return failed != 0;
+}
@@ -0,0 +1,106 @@
+// hashes the chunks of a few fixed areas of the world and compares them against the
+// values recorded below, for the float build (golden) and the FIXED_NOISE one (goldenfx).
+// a change meant to keep the terrain as it is has to leave these alone; one that changes
+// it on purpose records the new values, printed by: golden print.
+// column jobs have to give the same blocks as chunks generated one at a time
+// usage: golden [print]
+
+#include "worldgen.hpp"
+
+#include <cstring>
+
+struct Area {
+	s16 cx, cy; // first column
+	s16 side;
+};
+
+constexpr Area areas[] = {
+	{ -4, -4, 8 },
+	{ -40, 25, 4 },
+	{ 300, -180, 4 },
+	{ -2000, -1500, 4 },
+	{ 10000, 7000, 4 },
+};
+constexpr int areaCount = sizeof(areas) / sizeof(areas[0]);
+
+constexpr int lattices[] = { 1, 4 };
+constexpr int latticeCount = sizeof(lattices) / sizeof(lattices[0]);
+
+#ifdef FIXED_NOISE
+constexpr char const *build = "FIXED_NOISE";
+constexpr u64 goldenHashes[latticeCount][areaCount] = {
+	{ 0xc30a1deaec105925, 0xabf8086887f16425, 0xa6bfb52e0d13f325, 0x52dbe0fc7c44ce25, 0xc1c3da8041a59f25 },
+	{ 0x6555c5406a7ceb25, 0x0d7e5efb73292a25, 0x6fe4087a55d36e25, 0xceaf5d2162b9f225, 0x68eb798f921f5a25 },
+};
+#else
+constexpr char const *build = "float";
+constexpr u64 goldenHashes[latticeCount][areaCount] = {
+	{ 0x6330419b7ee77725, 0x6b044e04107eb225, 0x5d443fc50d10e125, 0x8e6cc91fe4072825, 0xba5e1299e60cda25 },
+	{ 0xbae14905fea84125, 0x97d9acf063f59c25, 0x71a3415683450425, 0xcf2bd8ed60b5ac25, 0xf17c074fa87d9e25 },
+};
+#endif
+
+u64 hashChunk(u64 h, ChunkBlocks &c) {
+	for (int z = 0; z < chunkSize; ++z)
+		for (int y = 0; y < chunkSize; ++y)
+			for (int x = 0; x < chunkSize; ++x)
+				h = (h ^ c.get(x, y, z).value) * 0x100000001b3;
+	c.release();
+	return h;
+}
+
+u64 hashArea(Area const &a, bool columns) {
+	u64 h = 0xcbf29ce484222325;
+	std::array<ChunkBlocks, columnChunks> column;
+	for (int cy = a.cy; cy < a.cy + a.side; ++cy)
+		for (int cx = a.cx; cx < a.cx + a.side; ++cx)
+			if (columns) {
+				generateColumnChunks(cx, cy, column);
+				for (auto &c: column)
+					h = hashChunk(h, c);
+			} else
+				for (int cz = -zChunks; cz <= zChunks; ++cz) {
+					auto c = generateChunk(cx, cy, cz);
+					h = hashChunk(h, c);
+				}
+	return h;
+}
+
+int main(int argc, char **argv) {
+
+	bool print = argc > 1 && !strcmp(argv[1], "print");
+
+	u64 hashes[latticeCount][areaCount];
+	int columnsDiffer = 0;
+	for (int l = 0; l < latticeCount; ++l) {
+		worldgen::setDensityLattice(lattices[l]);
+		for (int a = 0; a < areaCount; ++a) {
+			hashes[l][a] = hashArea(areas[a], false);
+			columnsDiffer += hashArea(areas[a], true) != hashes[l][a];
+		}
+	}
+
+	if (print) {
+		for (auto &row: hashes) {
+			printf("\t{ ");
+			for (int a = 0; a < areaCount; ++a)
+				printf("0x%016llx%s", (unsigned long long)row[a], a + 1 < areaCount ? ", " : "");
+			printf(" },\n");
+		}
+		return 0;
+	}
+
+	int differ = 0;
+	for (int l = 0; l < latticeCount; ++l)
+		for (int a = 0; a < areaCount; ++a)
+			if (hashes[l][a] != goldenHashes[l][a]) {
+				printf("lattice %d, %dx%d columns at %d, %d: %016llx, recorded %016llx\n",
+					lattices[l], areas[a].side, areas[a].side, areas[a].cx, areas[a].cy,
+					(unsigned long long)hashes[l][a], (unsigned long long)goldenHashes[l][a]);
+				++differ;
+			}
+
+	printf("%s build: %d of %d areas differ, %d differ between column jobs and single chunks\n",
+		build, differ, latticeCount * areaCount, columnsDiffer);
+	return differ + columnsDiffer != 0;
+}
@@ -0,0 +1,149 @@
+// chunk lookups through the resident grid against the old unordered_map world
+// usage: gridbench [passes]
+
+#include "chunkgrid.hpp"
+#include "worldgen.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <unordered_map>
+
+constexpr int distanceUnload = 8; // as in world.hpp
+constexpr int side = distanceUnload * 2 + 1;
+
+using Grid = ChunkGrid<ChunkBlocks, side, -zChunks, zChunks>;
+using Map = std::unordered_map<s16vec3, ChunkBlocks, s16vec3::hash>;
+
+struct GridWorld {
+	Grid grid;
+	ChunkBlocks const *find(s16 x, s16 y, s16 z) { return grid.find(x, y, z); }
+};
+
+struct MapWorld {
+	Map map;
+	ChunkBlocks const *find(s16 x, s16 y, s16 z) {
+		auto it = map.find({x, y, z});
+		return it != map.end() ? &it->second : nullptr;
+	}
+};
+
+template <typename World>
+Block getBlock(World &w, int x, int y, int z) {
+	auto *ch = w.find(x >> chunkBits, y >> chunkBits, z >> chunkBits);
+	return ch ? ch->get(x & chunkMask, y & chunkMask, z & chunkMask) : Block { 0xffff };
+}
+
+// collision style: random blocks in the loaded cage
+template <typename World>
+u32 randomBlocks(World &w, int n) {
+	u32 state = 7, sum = 0;
+	int extent = distanceUnload * chunkSize;
+	for (int i = 0; i < n; ++i) {
+		state = state * 1664525 + 1013904223;
+		int x = (int)((state >> 8) % (2 * extent)) - extent;
+		state = state * 1664525 + 1013904223;
+		int y = (int)((state >> 8) % (2 * extent)) - extent;
+		int z = (int)((state >> 8) % (chunkSize * columnChunks)) - chunkSize * zChunks;
+		sum += getBlock(w, x, y, z).value;
+	}
+	return sum;
+}
+
+// raycast style: unit steps along random rays from the centre until a solid block
+template <typename World>
+u32 rays(World &w, int n, int &steps) {
+	u32 state = 11, sum = 0;
+	steps = 0;
+	for (int i = 0; i < n; ++i) {
+		state = state * 1664525 + 1013904223;
+		float a = (state >> 8) * (6.2831853f / (1 << 24));
+		state = state * 1664525 + 1013904223;
+		float b = ((state >> 8) * (1.0f / (1 << 24)) - 0.5f) * 0.5f;
+		float dx = cosf(a), dy = sinf(a), dz = b;
+		float px = 0.5f, py = 0.5f, pz = 30.5f;
+		for (int s = 0; s < 120; ++s, ++steps) {
+			px += dx; py += dy; pz += dz;
+			auto blk = getBlock(w, fastFloor(px), fastFloor(py), fastFloor(pz));
+			if (blk.value == 0xffff || blk.isSolid()) {
+				sum += blk.value;
+				break;
+			}
+		}
+	}
+	return sum;
+}
+
+// scheduling style: every chunk of the cage around a shifting centre asks for its six neighbours
+template <typename World>
+u32 neighbours(World &w, int shift) {
+	u32 found = 0;
+	for (int z = -zChunks; z <= zChunks; ++z)
+		for (int y = shift - distanceUnload; y <= shift + distanceUnload; ++y)
+			for (int x = shift - distanceUnload; x <= shift + distanceUnload; ++x) {
+				found += w.find(x - 1, y, z) != nullptr;
+				found += w.find(x + 1, y, z) != nullptr;
+				found += w.find(x, y - 1, z) != nullptr;
+				found += w.find(x, y + 1, z) != nullptr;
+				found += w.find(x, y, z - 1) != nullptr;
+				found += w.find(x, y, z + 1) != nullptr;
+			}
+	return found;
+}
+
+template <typename World>
+void run(char const *name, World &w, int passes) {
+	u64 start = svcGetSystemTick();
+	int n = 1 << 20;
+	u32 a = 0;
+	for (int p = 0; p < passes; ++p)
+		a += randomBlocks(w, n);
+	float tRandom = (svcGetSystemTick() - start) * invTickRate / (passes * (float)n);
+
+	start = svcGetSystemTick();
+	int steps = 0, raysN = 1 << 14;
+	u32 b = 0;
+	for (int p = 0; p < passes; ++p)
+		b += rays(w, raysN, steps);
+	float tRays = (svcGetSystemTick() - start) * invTickRate / (passes * (float)steps);
+
+	start = svcGetSystemTick();
+	u32 c = 0;
+	for (int p = 0; p < passes * 64; ++p)
+		c += neighbours(w, p % 5 - 2);
+	float tSides = (svcGetSystemTick() - start) * invTickRate / (passes * 64 * 6 * (float)Grid::size);
+
+	printf("  %-14s random %5.2f ns  ray step %5.2f ns  neighbour %5.2f ns  (%u %u %u)\n",
+		name, tRandom * 1e9f, tRays * 1e9f, tSides * 1e9f, a >> 8, b >> 8, c);
+}
+
+int main(int argc, char **argv) {
+
+	int passes = argc > 1 ? atoi(argv[1]) : 4;
+
+	static GridWorld grid;
+	MapWorld map;
+
+	std::array<ChunkBlocks, columnChunks> out;
+	for (int cy = -distanceUnload; cy <= distanceUnload; ++cy)
+		for (int cx = -distanceUnload; cx <= distanceUnload; ++cx) {
+			generateColumnChunks(cx, cy, out);
+			for (int i = 0; i < columnChunks; ++i) {
+				s16vec3 idx { (s16)cx, (s16)cy, (s16)(i - zChunks) };
+				out[i].pack();
+				*grid.grid.insert(idx) = out[i];
+				map.map[idx] = out[i];
+			}
+		}
+
+	size_t maxBucket = 0;
+	for (size_t b = 0; b < map.map.bucket_count(); ++b)
+		maxBucket = std::max(maxBucket, map.map.bucket_size(b));
+	printf("%zu chunks, map load %.2f, largest bucket %zu\n",
+		map.map.size(), map.map.load_factor(), maxBucket);
+
+	run("unordered_map", map, passes);
+	run("grid", grid, passes);
+
+	for (auto &[idx, blocks]: map.map)
+		blocks.release();
+}
@@ -0,0 +1,79 @@
+// cost per column of the heightmap stage for a few layer setups
+// usage: hmbench [radius in columns]
+
+#include "worldgen.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using worldgen::HeightLayer;
+
+struct Setup {
+	char const *name;
+	std::vector<HeightLayer> layers;
+	int reference; // setup with the same octaves at full resolution, -1 for none
+};
+
+std::vector<int> heights(int radius) {
+	std::vector<int> out;
+	worldgen::Column c;
+	for (int cy = -radius; cy < radius; ++cy)
+		for (int cx = -radius; cx < radius; ++cx) {
+			worldgen::heightmapStage(c, cx, cy);
+			for (auto &row: c.blocks)
+				for (auto &b: row)
+					out.push_back(b.height);
+		}
+	return out;
+}
+
+int main(int argc, char **argv) {
+
+	int radius = argc > 1 ? atoi(argv[1]) : 16;
+	int columns = radius * radius * 4;
+
+	std::vector<HeightLayer> octaves {
+		{ 0, 0.005f, 12.0f }, { 1, 0.02f, 4.0f }, { 2, 0.06f, 1.5f }, { 3, 0.15f, 0.5f },
+	};
+	auto coarse = octaves;
+	coarse[0].step = 16;
+	coarse[1].step = 4;
+
+	std::vector<Setup> setups {
+		{ "1 octave, per block (stock)", worldgen::getHeightLayers(), -1 },
+		{ "1 octave, lattice 4", { { 0, 0.02f, 4.0f, 4 } }, 0 },
+		{ "4 octaves, per block", octaves, -1 },
+		{ "4 octaves, 2 on lattices", coarse, 2 },
+	};
+
+	std::vector<std::vector<int>> results;
+
+	for (auto &s: setups) {
+
+		worldgen::setHeightLayers(s.layers);
+
+		// best of a few runs, the region is small
+		float best = 1e9f;
+		for (int run = 0; run < 5; ++run) {
+			u64 start = svcGetSystemTick();
+			auto h = heights(radius);
+			best = std::min(best, (svcGetSystemTick() - start) * invTickRate);
+			if (run == 0)
+				results.push_back(std::move(h));
+		}
+
+		printf("%-28s %7.2f us per column", s.name, best / columns * 1e6f);
+
+		if (s.reference >= 0) {
+			auto &a = results.back(), &b = results[s.reference];
+			int differ = 0, worst = 0;
+			for (size_t i = 0; i < a.size(); ++i) {
+				differ += a[i] != b[i];
+				worst = std::max(worst, std::abs(a[i] - b[i]));
+			}
+			printf(", %.2f%% heights differ, at most by %d", differ * 100.0f / a.size(), worst);
+		}
+		printf("\n");
+	}
+}
@@ -0,0 +1,134 @@
+// ChunkMap against std::unordered_map with the vec3 xor hash
+// usage: mapbench [radius in chunks]
+
+#include "chunkmap.hpp"
+
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+using StdMap = std::unordered_map<s16vec3, u32, s16vec3::hash>;
+
+// cage of chunks around x0, y0 like the loaded world, or a flat area of columns
+std::vector<s16vec3> area(int radius, int x0, int y0, bool columns) {
+	std::vector<s16vec3> out;
+	int z0 = columns ? 0 : -2, z1 = columns ? 0 : 2;
+	for (int z = z0; z <= z1; ++z)
+		for (int y = -radius; y <= radius; ++y)
+			for (int x = -radius; x <= radius; ++x)
+				out.push_back({ (s16)(x + x0), (s16)(y + y0), (s16)z });
+	return out;
+}
+
+float seconds(u64 start) { return (svcGetSystemTick() - start) * invTickRate; }
+
+void compare(char const *name, std::vector<s16vec3> const &keys) {
+
+	StdMap std;
+	ChunkMap<u32> flat;
+	for (u32 i = 0; i < keys.size(); ++i) {
+		std[keys[i]] = i;
+		flat[chunkKey(keys[i].x, keys[i].y, keys[i].z)] = i;
+	}
+
+	// chain length the lookup walks in the bucket, against slots probed
+	double chain = 0, probes = 0;
+	size_t maxChain = 0;
+	int maxProbes = 0;
+	for (auto &k: keys) {
+		size_t c = std.bucket_size(std.bucket(k));
+		int p = flat.probes(chunkKey(k.x, k.y, k.z));
+		chain += c; probes += p;
+		maxChain = std::max(maxChain, c);
+		maxProbes = std::max(maxProbes, p);
+	}
+
+	// misses: same shape, shifted out of the area
+	std::vector<s16vec3> misses = keys;
+	for (auto &k: misses)
+		k.x += 1000;
+
+	int reps = std::max(1, (1 << 22) / (int)keys.size());
+	u32 sum = 0;
+
+	u64 start = svcGetSystemTick();
+	for (int r = 0; r < reps; ++r)
+		for (auto &k: keys)
+			sum += std.find(k)->second;
+	float stdHit = seconds(start);
+	start = svcGetSystemTick();
+	for (int r = 0; r < reps; ++r)
+		for (auto &k: misses)
+			sum += std.find(k) != std.end();
+	float stdMiss = seconds(start);
+
+	u32 check = sum;
+	sum = 0;
+	start = svcGetSystemTick();
+	for (int r = 0; r < reps; ++r)
+		for (auto &k: keys)
+			sum += *flat.find(chunkKey(k.x, k.y, k.z));
+	float flatHit = seconds(start);
+	start = svcGetSystemTick();
+	for (int r = 0; r < reps; ++r)
+		for (auto &k: misses)
+			sum += flat.find(chunkKey(k.x, k.y, k.z)) != nullptr;
+	float flatMiss = seconds(start);
+
+	float n = (float)reps * keys.size() / 1e9f;
+	printf("%s: %zu keys%s\n", name, keys.size(), sum == check ? "" : ", RESULTS DIFFER");
+	printf("  unordered_map  chain %5.2f avg %4zu max  hit %6.2f ns  miss %6.2f ns\n",
+		chain / keys.size(), maxChain, stdHit / n, stdMiss / n);
+	printf("  ChunkMap       probe %5.2f avg %4d max  hit %6.2f ns  miss %6.2f ns  (%u slots)\n",
+		probes / keys.size(), maxProbes, flatHit / n, flatMiss / n, flat.capacity());
+}
+
+// a window sliding along x, erasing the chunks it leaves, like the chunk cache
+void churn(int radius) {
+
+	StdMap std;
+	ChunkMap<u32> flat;
+	int steps = 256;
+
+	auto run = [&](auto &&insert, auto &&erase) {
+		u64 start = svcGetSystemTick();
+		for (int s = 0; s < steps; ++s)
+			for (int z = -2; z <= 2; ++z)
+				for (int y = -radius; y <= radius; ++y) {
+					insert(s16vec3 { (s16)(s + radius), (s16)y, (s16)z }, s);
+					erase(s16vec3 { (s16)(s - radius - 1), (s16)y, (s16)z });
+				}
+		return seconds(start);
+	};
+
+	float tStd = run(
+		[&](s16vec3 k, u32 v) { std[k] = v; },
+		[&](s16vec3 k) { std.erase(k); });
+	float tFlat = run(
+		[&](s16vec3 k, u32 v) { flat[chunkKey(k.x, k.y, k.z)] = v; },
+		[&](s16vec3 k) { flat.erase(chunkKey(k.x, k.y, k.z)); });
+
+	// every key left must agree, and nothing else may be found
+	int wrong = std.size() != flat.size();
+	for (auto &[k, v]: std) {
+		auto *f = flat.find(chunkKey(k.x, k.y, k.z));
+		wrong += !f || *f != v;
+	}
+	for (int x = -radius - 1; x < steps - radius - 1; ++x)
+		wrong += flat.find(chunkKey(x, 0, 0)) != nullptr;
+
+	float n = steps * 5.0f * (2 * radius + 1) / 1e9f;
+	printf("sliding window: %u live, %d mismatches\n", flat.size(), wrong);
+	printf("  unordered_map  %6.2f ns per insert + erase\n", tStd / n);
+	printf("  ChunkMap       %6.2f ns per insert + erase\n", tFlat / n);
+}
+
+int main(int argc, char **argv) {
+
+	int radius = argc > 1 ? atoi(argv[1]) : 16;
+
+	compare("chunk cage at origin", area(radius, 0, 0, false));
+	compare("chunk cage at 3000, -5000", area(radius, 3000, -5000, false));
+	compare("column area", area(radius, 0, 0, true));
+	churn(radius);
+}
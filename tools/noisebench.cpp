@@ -0,0 +1,122 @@
+// the batched noise entry points against the single-point functions over the same
+// points, timed and compared bit for bit; the grid and run helpers are checked against
+// the coordinates they stand for
+// usage: noisebench [side of the point grid]
+
+#include "common.hpp"
+#include "noise.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+constexpr float heightScale = 1.0f / 128;
+constexpr float caveScale = 1.0f / 24;
+constexpr int seed = 1337;
+
+int differing(std::vector<float> const &a, std::vector<float> const &b) {
+	int n = 0;
+	for (size_t i = 0; i < a.size(); ++i)
+		n += memcmp(&a[i], &b[i], sizeof(float)) != 0;
+	return n;
+}
+
+void report(char const *name, int points, u64 scalar, u64 batch, int differ) {
+	float s = scalar * invTickRate, b = batch * invTickRate;
+	printf("%-8s %8d points: scalar %7.2f ns, batch %7.2f ns a point, %.2fx, %d differ\n",
+		name, points, s * 1e9f / points, b * 1e9f / points, s / b, differ);
+}
+
+int main(int argc, char **argv) {
+
+	int side = argc > 1 ? atoi(argv[1]) : 512;
+	int points = side * side;
+	int failed = 0;
+
+	// odd offsets so that lanes see negative and positive coordinates
+	std::vector<float> xs(points), ys(points), zs(points), scalar(points), batch(points);
+	for (int j = 0; j < side; ++j)
+		for (int i = 0; i < side; ++i) {
+			xs[i + j * side] = (i - side / 3) * caveScale;
+			ys[i + j * side] = (j - side / 2) * caveScale;
+			zs[i + j * side] = ((i ^ j) % 48 - 32) * caveScale;
+		}
+
+	u64 start = svcGetSystemTick();
+	for (int n = 0; n < points; ++n)
+		scalar[n] = noise2d(seed, xs[n], ys[n]);
+	u64 scalarTicks = svcGetSystemTick() - start;
+	start = svcGetSystemTick();
+	noise2dBatch(seed, xs.data(), ys.data(), batch.data(), points);
+	u64 batchTicks = svcGetSystemTick() - start;
+	int differ = differing(scalar, batch);
+	report("2d", points, scalarTicks, batchTicks, differ);
+	failed += differ;
+
+	start = svcGetSystemTick();
+	for (int n = 0; n < points; ++n)
+		scalar[n] = noise3d(seed, xs[n], ys[n], zs[n]);
+	scalarTicks = svcGetSystemTick() - start;
+	start = svcGetSystemTick();
+	noise3dBatch(seed, xs.data(), ys.data(), zs.data(), batch.data(), points);
+	batchTicks = svcGetSystemTick() - start;
+	differ = differing(scalar, batch);
+	report("3d", points, scalarTicks, batchTicks, differ);
+	failed += differ;
+
+	// odd counts leave a tail for the scalar loop
+	for (int count: { 1, 7, 13 }) {
+		std::vector<float> a(count), b(count);
+		noise3dBatch(seed, xs.data(), ys.data(), zs.data(), a.data(), count);
+		noise2dBatch(seed, xs.data(), ys.data(), b.data(), count);
+		for (int n = 0; n < count; ++n) {
+			failed += a[n] != noise3d(seed, xs[n], ys[n], zs[n]);
+			failed += b[n] != noise2d(seed, xs[n], ys[n]);
+		}
+	}
+
+	// one 16x16 grid a column, as the heightmap stage asks for them
+	int grids = side * side / (noiseGridSize * noiseGridSize);
+	int gridSide = side / noiseGridSize;
+	std::vector<float> gridScalar(grids * noiseGridSize * noiseGridSize), grid(gridScalar.size());
+	start = svcGetSystemTick();
+	for (int g = 0; g < grids; ++g) {
+		int x0 = (g % gridSide - gridSide / 2) * noiseGridSize, y0 = (g / gridSide - gridSide / 2) * noiseGridSize;
+		for (int j = 0; j < noiseGridSize; ++j)
+			for (int i = 0; i < noiseGridSize; ++i)
+				gridScalar[g * noiseGridSize * noiseGridSize + i + j * noiseGridSize] =
+					noise2d(seed, (x0 + i) * heightScale, (y0 + j) * heightScale);
+	}
+	scalarTicks = svcGetSystemTick() - start;
+	start = svcGetSystemTick();
+	for (int g = 0; g < grids; ++g) {
+		int x0 = (g % gridSide - gridSide / 2) * noiseGridSize, y0 = (g / gridSide - gridSide / 2) * noiseGridSize;
+		noise2dGrid(seed, x0, y0, heightScale, &grid[g * noiseGridSize * noiseGridSize]);
+	}
+	batchTicks = svcGetSystemTick() - start;
+	differ = differing(gridScalar, grid);
+	report("2d grid", grid.size(), scalarTicks, batchTicks, differ);
+#ifndef FIXED_NOISE
+	// the fixed-point grid only matches to within a fraction of a block
+	failed += differ;
+#endif
+
+	// vertical runs of a chunk's height, as the caves stage asks for them
+	int runs = points / noiseGridSize;
+	std::vector<float> runScalar(points), run(points);
+	start = svcGetSystemTick();
+	for (int r = 0; r < runs; ++r)
+		for (int k = 0; k < noiseGridSize; ++k)
+			runScalar[r * noiseGridSize + k] = noise3d(seed, (r % side) * caveScale, (r / side) * caveScale, (k - 32) * caveScale);
+	scalarTicks = svcGetSystemTick() - start;
+	start = svcGetSystemTick();
+	for (int r = 0; r < runs; ++r)
+		noise3dRun(seed, r % side, r / side, -32, caveScale, &run[r * noiseGridSize], noiseGridSize);
+	batchTicks = svcGetSystemTick() - start;
+	differ = differing(runScalar, run);
+	report("3d run", points, scalarTicks, batchTicks, differ);
+	failed += differ;
+
+	printf(failed ? "FAILED\n" : "ok\n");
+	return failed != 0;
+}
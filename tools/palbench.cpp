@@ -0,0 +1,88 @@
+// resident memory and access costs of paletted chunks against the dense layout
+// usage: palbench [radius in columns]
+
+#include "worldgen.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char **argv) {
+
+	int radius = argc > 1 ? atoi(argv[1]) : 8;
+
+	std::vector<ChunkBlocks> dense, paletted;
+	std::array<ChunkBlocks, columnChunks> out;
+	for (int cy = -radius; cy < radius; ++cy)
+		for (int cx = -radius; cx < radius; ++cx) {
+			generateColumnChunks(cx, cy, out);
+			for (auto &c: out) {
+				if (c.isUniform()) {
+					c.release();
+					continue;
+				}
+				ChunkBlocks p { createChunk() };
+				*p.dense = *c.dense;
+				p.pack();
+				dense.push_back(c);
+				paletted.push_back(p);
+			}
+		}
+
+	size_t denseBytes = 0, palettedBytes = 0;
+	int widths[4] = {}, stillDense = 0, mismatched = 0;
+	for (size_t i = 0; i < dense.size(); ++i) {
+		denseBytes += dense[i].bytes();
+		palettedBytes += paletted[i].bytes();
+		if (paletted[i].paletted)
+			++widths[paletted[i].paletted->logBits];
+		else
+			++stillDense;
+		for (int z = 0; z < chunkSize; ++z)
+			for (int y = 0; y < chunkSize; ++y)
+				for (int x = 0; x < chunkSize; ++x)
+					mismatched += dense[i].get(x, y, z).value != paletted[i].get(x, y, z).value;
+	}
+
+	printf("%zu non-uniform chunks, %d blocks differ\n", dense.size(), mismatched);
+	printf("  bits per block: 1 x%d, 2 x%d, 4 x%d, 8 x%d, dense x%d\n",
+		widths[0], widths[1], widths[2], widths[3], stillDense);
+	printf("  dense %.1f KiB, paletted %.1f KiB, %.1fx smaller\n",
+		denseBytes / 1024.0f, palettedBytes / 1024.0f, (float)denseBytes / palettedBytes);
+
+	// same pseudo-random positions for both layouts
+	auto randomAccess = [&](std::vector<ChunkBlocks> const &chunks) {
+		u32 state = 1, sum = 0;
+		int n = 1 << 22;
+		u64 start = svcGetSystemTick();
+		for (int i = 0; i < n; ++i) {
+			state = state * 1664525 + 1013904223;
+			auto &c = chunks[(state >> 8) % chunks.size()];
+			u32 p = state >> 20;
+			sum += c.get(p & 15, (p >> 4) & 15, (p >> 8) & 15).value;
+		}
+		float t = (svcGetSystemTick() - start) * invTickRate;
+		printf(" %6.2f ns per get (%u)", t / n * 1e9f, sum >> 8);
+	};
+
+	auto bulkScan = [&](std::vector<ChunkBlocks> const &chunks) {
+		std::array<Block, chunkSize> row;
+		u32 sum = 0;
+		int passes = 8;
+		u64 start = svcGetSystemTick();
+		for (int pass = 0; pass < passes; ++pass)
+			for (auto &c: chunks)
+				for (int z = 0; z < chunkSize; ++z)
+					for (int y = 0; y < chunkSize; ++y) {
+						c.getRow(y, z, row.data());
+						sum += row[y].value;
+					}
+		float t = (svcGetSystemTick() - start) * invTickRate;
+		printf(" %6.2f us per chunk scan (%u)", t / (passes * chunks.size()) * 1e6f, sum >> 8);
+	};
+
+	printf("  dense:   "); randomAccess(dense); bulkScan(dense); printf("\n");
+	printf("  paletted:"); randomAccess(paletted); bulkScan(paletted); printf("\n");
+
+	for (auto &c: dense) c.release();
+	for (auto &c: paletted) c.release();
+}
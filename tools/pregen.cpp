@@ -0,0 +1,69 @@
+// pregenerates a square of columns around the origin into a region file for romfs
+// usage: pregen <output file> [radius in columns] [threads]
+// build it with the same noise flags as the game (FIXED_NOISE) or the game will ignore the file
+
+#include "worldgen.hpp"
+#include "region.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// column i of the region as (i % side - radius, i / side - radius)
+void generateColumns(int radius, std::atomic<int> &next, std::vector<region::EncodedChunk> &chunks) {
+	int side = radius * 2;
+	std::array<ChunkBlocks, columnChunks> out;
+	for (int i; (i = next.fetch_add(1)) < side * side;) {
+		generateColumnChunks(i % side - radius, i / side - radius, out);
+		for (int z = 0; z < columnChunks; ++z) {
+			chunks[i * columnChunks + z] = region::encode(out[z]);
+			out[z].release();
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+
+	if (argc < 2) {
+		printf("usage: %s <output file> [radius in columns] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	int radius = argc > 2 ? atoi(argv[2]) : 16;
+	int threads = argc > 3 ? atoi(argv[3]) : std::thread::hardware_concurrency();
+	if (radius < 1 || radius > 256)
+		radius = 16;
+	if (threads < 1)
+		threads = 1;
+
+	int side = radius * 2;
+	std::vector<region::EncodedChunk> chunks(side * side * columnChunks);
+	std::atomic<int> next = 0;
+
+	u64 start = svcGetSystemTick();
+
+	std::vector<std::thread> pool;
+	for (int t = 0; t < threads; ++t)
+		pool.emplace_back(generateColumns, radius, std::ref(next), std::ref(chunks));
+	for (auto &t: pool)
+		t.join();
+
+	float total = (svcGetSystemTick() - start) * invTickRate;
+
+	if (!region::write(argv[1], -radius, -radius, side, chunks)) {
+		printf("could not write %s\n", argv[1]);
+		return 1;
+	}
+
+	size_t bytes = sizeof(region::Header) + sizeof(region::Entry) * chunks.size();
+	int uniform = 0;
+	for (auto &c: chunks) {
+		bytes += c.runs.size() * sizeof(u16);
+		uniform += c.runs.empty();
+	}
+
+	printf("%zu chunks (%d uniform) on %d threads in %.3f s, %.0f chunks/s\n",
+		chunks.size(), uniform, threads, total, chunks.size() / total);
+	printf("%s: %.1f KiB, %.0f bytes per chunk\n", argv[1], bytes / 1024.0f, (float)bytes / chunks.size());
+}
@@ -0,0 +1,121 @@
+// patching a mesh after block edits against meshing the chunk again; every spliced
+// mesh has to match the full one exactly
+// usage: remeshbench [edits]
+
+#include "mesher.hpp"
+#include "worldgen.hpp"
+
+#include <cstdlib>
+
+struct Mesh {
+	std::vector<vertex> vertices;
+	std::vector<u16> indices;
+	std::vector<MesherAllocation::Mesh> meshes;
+};
+
+Mesh copy(MesherAllocation const &a) {
+	Mesh m;
+	auto *v = static_cast<vertex const *>(a.vertices);
+	m.vertices.assign(v, v + a.vertexCount);
+	int indices = 0;
+	for (auto &sub: a.meshes)
+		indices += sub.count;
+	auto *i = static_cast<u16 const *>(a.indices);
+	m.indices.assign(i, i + indices);
+	m.meshes = a.meshes;
+	return m;
+}
+
+bool same(MesherAllocation const &x, MesherAllocation const &y) {
+	auto a = copy(x), b = copy(y);
+	if (a.vertices.size() != b.vertices.size() || a.indices != b.indices || a.meshes.size() != b.meshes.size())
+		return false;
+	for (size_t i = 0; i < a.meshes.size(); ++i)
+		if (a.meshes[i].count != b.meshes[i].count || a.meshes[i].texture != b.meshes[i].texture)
+			return false;
+	return !memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(vertex));
+}
+
+int main(int argc, char **argv) {
+
+	int edits = argc > 1 ? atoi(argv[1]) : 2000;
+
+	std::array<std::array<ChunkBlocks, columnChunks>, 9> columns;
+	for (int c = 0; c < 9; ++c) {
+		generateColumnChunks(c % 3 - 1, c / 3 - 1, columns[c]);
+		for (auto &ch: columns[c])
+			ch.pack();
+	}
+
+	// the surface chunk, with the most going on
+	int cz = zChunks;
+	ChunkNeighbourhood n;
+	for (int dz = -1; dz < 2; ++dz)
+		for (int dy = -1; dy < 2; ++dy)
+			for (int dx = -1; dx < 2; ++dx)
+				n[neighbourIndex(dx, dy, dz)] = &columns[(dy + 1) * 3 + dx + 1][cz + dz];
+
+	static expandedChunk ex;
+	expandChunk(n, ex);
+	auto base = meshChunk(ex);
+	printf("surface chunk: %u vertices\n", base.vertexCount);
+
+	u32 state = 1;
+	auto next = [&](int range) {
+		state = state * 1664525 + 1013904223;
+		return (int)((state >> 8) % range);
+	};
+
+	int failed = 0, segments = 0, remeshes = 0;
+	u64 fullTicks = 0, patchTicks = 0, spliceTicks = 0;
+
+	for (int e = 0; e < edits;) {
+
+		// a few edits before each remesh, in the chunk and in the layers around it
+		std::array<u32, 3> dirty {};
+		for (int k = next(3) + 1; k > 0 && e < edits; --k, ++e) {
+			int x = next(chunkSize + 2) - 1, y = next(chunkSize + 2) - 1, z = next(chunkSize + 2) - 1;
+			int dx = x < 0 ? -1 : x >= chunkSize, dy = y < 0 ? -1 : y >= chunkSize, dz = z < 0 ? -1 : z >= chunkSize;
+			auto &target = columns[(dy + 1) * 3 + dx + 1][cz + dz];
+			Block b = next(2) ? Block { 0 } : Block::solid(next(3));
+			target.set(x & chunkMask, y & chunkMask, z & chunkMask, b);
+			dirty[0] |= 1u << (x + 1);
+			dirty[1] |= 1u << (y + 1);
+			dirty[2] |= 1u << (z + 1);
+		}
+		expandChunk(n, ex);
+
+		auto mask = dirtySegments(dirty);
+		segments += mask.count();
+		++remeshes;
+
+		u64 start = svcGetSystemTick();
+		auto full = meshChunk(ex);
+		u64 t1 = svcGetSystemTick();
+		auto patch = meshChunk(ex, mask);
+		u64 t2 = svcGetSystemTick();
+		auto spliced = spliceMesh(base, patch);
+		u64 t3 = svcGetSystemTick();
+		fullTicks += t1 - start; patchTicks += t2 - t1; spliceTicks += t3 - t2;
+
+		if (!same(full, spliced))
+			++failed;
+
+		freeMesh(full);
+		freeMesh(patch);
+		freeMesh(base);
+		base = std::move(spliced);
+	}
+
+	float us = invTickRate * 1e6f / remeshes;
+	printf("%d edits in %d remeshes, %.1f of %d segments dirty on average, %d splices differ\n",
+		edits, remeshes, (float)segments / remeshes, meshSegments, failed);
+	printf("  full mesh %.1f us, patch %.1f us + splice %.1f us\n",
+		fullTicks * us, patchTicks * us, spliceTicks * us);
+
+	freeMesh(base);
+	for (auto &col: columns)
+		for (auto &c: col)
+			c.release();
+	return failed != 0;
+}
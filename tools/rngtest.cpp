@@ -0,0 +1,181 @@
+// statistical checks and throughput of the worldgen rng against the old simpleHash,
+// and rng::column against the single draws it stands for. built without the host's
+// auto-vectoriser, so the timings are of the scalar code the 3ds runs
+// usage: rngtest [side in blocks]
+
+#include "rng.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// the hash decoration drew from before, one call a block, kept as a baseline
+constexpr u32 xorshift(u32 v, int s) {
+	return v ^ (v >> s);
+}
+
+constexpr u32 simpleHash(u32 a, u32 b, u32 c) {
+	u32 i = xorshift(a * (u32)0x1234567, 16);
+	u32 j = xorshift((b + i) * (u32)1073726623, 16);
+	u32 k = xorshift((c + j) * (u32)2654435761, 16);
+	return k;
+}
+
+// rng::column against rng::at for every block of columns on both sides of zero and at
+// the ends of the coordinate range, with a few keys; the number of differing draws
+int columnMismatches() {
+	int differ = 0;
+	std::vector<u16> out(rng::columnSize);
+	for (u32 key: { 0u, 1u, 0x9e3779b9u, 0xffffffffu })
+		for (int cy = -3; cy < 3; ++cy)
+			for (int cx: { -70000, -3, -2, -1, 0, 1, 2, 70000, INT32_MAX / chunkSize }) {
+				int x0 = cx * chunkSize, y0 = cy * chunkSize + cx;
+				rng::column(key, x0, y0, out.data());
+				for (int j = 0; j < chunkSize; ++j)
+					for (int i = 0; i < chunkSize; ++i)
+						differ += out[i + j * chunkSize] != rng::at(key, x0 + i, y0 + j);
+			}
+	return differ;
+}
+
+// chi-square over 256 buckets, 255 degrees of freedom: expect 255 +- 23
+double chiSquare(std::vector<u32> const &buckets, double total) {
+	double expected = total / buckets.size(), chi = 0;
+	for (auto b: buckets)
+		chi += (b - expected) * (b - expected) / expected;
+	return chi;
+}
+
+// a fair coin flipped n times came up ones times, in standard deviations
+double sigma(double ones, double n) {
+	return std::abs(ones - n / 2) / std::sqrt(n / 4);
+}
+
+// limits past which a test fails: 5 standard deviations for chi-square and bits
+constexpr double maxChiSquare = 255 + 5 * 23;
+constexpr double maxSigma = 5;
+
+// 16-bit draws over a square of blocks; false when one of the tests is past its limit
+template <typename F>
+bool quality(char const *name, int side, F draw) {
+
+	std::vector<u32> values(side * side);
+	for (int y = 0; y < side; ++y)
+		for (int x = 0; x < side; ++x)
+			values[x + y * side] = draw(x, y) & 0xffff;
+
+	double n = values.size();
+	double worstChi = 0, worstSigma = 0;
+	printf("%s\n", name);
+
+	// every byte on its own
+	for (int byte = 0; byte < 2; ++byte) {
+		std::vector<u32> buckets(256);
+		for (auto v: values)
+			++buckets[(v >> (byte * 8)) & 0xff];
+		double chi = chiSquare(buckets, n);
+		worstChi = std::max(worstChi, chi);
+		printf("  byte %d chi2 %8.1f\n", byte, chi);
+	}
+
+	// worst single bit against a fair coin
+	double worstBit = 0;
+	for (int bit = 0; bit < 16; ++bit) {
+		double ones = 0;
+		for (auto v: values)
+			ones += (v >> bit) & 1;
+		worstBit = std::max(worstBit, sigma(ones, n));
+	}
+	worstSigma = std::max(worstSigma, worstBit);
+	printf("  worst bit   %8.2f sigma\n", worstBit);
+
+	// low nibbles of horizontal and vertical neighbours together
+	std::vector<u32> pairsX(256), pairsY(256);
+	for (int y = 0; y + 1 < side; ++y)
+		for (int x = 0; x + 1 < side; ++x) {
+			u32 v = values[x + y * side] & 0xf;
+			++pairsX[v << 4 | (values[x + 1 + y * side] & 0xf)];
+			++pairsY[v << 4 | (values[x + (y + 1) * side] & 0xf)];
+		}
+	double pairs = (double)(side - 1) * (side - 1);
+	double chiX = chiSquare(pairsX, pairs), chiY = chiSquare(pairsY, pairs);
+	worstChi = std::max({ worstChi, chiX, chiY });
+	printf("  pairs x chi2 %7.1f, y chi2 %7.1f\n", chiX, chiY);
+
+	// each bit of neighbours should differ half the time
+	double worstFlip = 0;
+	for (int bit = 0; bit < 16; ++bit) {
+		double flipsX = 0, flipsY = 0;
+		for (int y = 0; y + 1 < side; ++y)
+			for (int x = 0; x + 1 < side; ++x) {
+				u32 v = values[x + y * side];
+				flipsX += ((v ^ values[x + 1 + y * side]) >> bit) & 1;
+				flipsY += ((v ^ values[x + (y + 1) * side]) >> bit) & 1;
+			}
+		worstFlip = std::max({ worstFlip, sigma(flipsX, pairs), sigma(flipsY, pairs) });
+	}
+	worstSigma = std::max(worstSigma, worstFlip);
+	printf("  worst flip  %8.2f sigma\n", worstFlip);
+
+	// the four blocks of a square xored together, which a hash of x and y that is
+	// merely xored or added together leaves at zero
+	std::vector<u32> squares(256);
+	for (int y = 0; y + 1 < side; ++y)
+		for (int x = 0; x + 1 < side; ++x)
+			++squares[(values[x + y * side] ^ values[x + 1 + y * side] ^
+				values[x + (y + 1) * side] ^ values[x + 1 + (y + 1) * side]) & 0xff];
+	double chiSquares = chiSquare(squares, pairs);
+	worstChi = std::max(worstChi, chiSquares);
+	printf("  squares chi2 %7.1f\n", chiSquares);
+
+	return worstChi <= maxChiSquare && worstSigma <= maxSigma;
+}
+
+template <typename F>
+void throughput(char const *name, F fill) {
+	std::vector<u16> out(rng::columnSize);
+	int columns = 0;
+	u64 start = svcGetSystemTick(), elapsed;
+	do {
+		for (int i = 0; i < 256; ++i, ++columns)
+			fill(columns, out.data());
+		elapsed = svcGetSystemTick() - start;
+	} while (elapsed < SYSCLOCK_ARM11 / 2);
+	float seconds = elapsed * invTickRate;
+	printf("  %-22s %6.2f ns a block (%u)\n", name, seconds * 1e9f / columns / rng::columnSize, out[7]);
+}
+
+int main(int argc, char **argv) {
+
+	int side = argc > 1 ? atoi(argv[1]) : 1024;
+
+	int mismatches = columnMismatches();
+	printf("rng::column against rng::at: %d draws differ\n", mismatches);
+
+	bool ok = true;
+	for (u32 key: { 0u, 1u, 0xdeadbeefu })
+		for (int offset: { 0, 1 << 19, -(1 << 19) + 77 }) {
+			char name[64];
+			snprintf(name, sizeof(name), "rng, key %x, from %d", key, offset);
+			ok = quality(name, side, [&](int x, int y) { return rng::at(key, x + offset, y - offset / 3); }) && ok;
+		}
+	quality("simpleHash", side, [](int x, int y) { return simpleHash(x, y, 0); });
+	printf("rng tests: %s\n", ok ? "ok" : "FAILED");
+
+	printf("throughput\n");
+	throughput("rng::column", [](int i, u16 *out) {
+		rng::column(0, i * chunkSize, 0, out);
+	});
+	throughput("rng::at", [](int i, u16 *out) {
+		for (int y = 0; y < chunkSize; ++y)
+			for (int x = 0; x < chunkSize; ++x)
+				out[x + y * chunkSize] = rng::at(0, i * chunkSize + x, y);
+	});
+	throughput("simpleHash", [](int i, u16 *out) {
+		for (int y = 0; y < chunkSize; ++y)
+			for (int x = 0; x < chunkSize; ++x)
+				out[x + y * chunkSize] = simpleHash(i * chunkSize + x, y, 0);
+	});
+
+	return !ok || mismatches;
+}
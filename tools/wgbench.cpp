@@ -0,0 +1,133 @@
+// generates a square of columns around the origin and prints where the time went
+// usage: wgbench [radius in columns] [density lattice step] [threads]
+// with a lattice step the region is generated again sampling every block and the
+// blocks that came out different are counted
+// with more than one thread the region is generated again in parallel and
+// checked against the single-threaded run
+
+#include "worldgen.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+u64 hashChunk(ChunkBlocks const &c) {
+	u64 h = 0xcbf29ce484222325;
+	for (int z = 0; z < chunkSize; ++z)
+		for (int y = 0; y < chunkSize; ++y)
+			for (int x = 0; x < chunkSize; ++x)
+				h = (h ^ c.get(x, y, z).value) * 0x100000001b3;
+	return h;
+}
+
+// column i of the region as (i % side - radius, i / side - radius)
+void generateColumns(int radius, std::atomic<int> &next, std::vector<u64> &hashes, int &uniform) {
+	int side = radius * 2;
+	std::array<ChunkBlocks, columnChunks> out;
+	for (int i; (i = next.fetch_add(1)) < side * side;) {
+		generateColumnChunks(i % side - radius, i / side - radius, out);
+		for (int z = 0; z < columnChunks; ++z) {
+			hashes[i * columnChunks + z] = hashChunk(out[z]);
+			uniform += out[z].isUniform();
+			out[z].release();
+		}
+	}
+}
+
+// the region with the lattice step set and again with every block sampled;
+// returns the blocks that differ and the time spent on the exact run, which finds
+// the heightmaps already cached and so comes out a little fast
+u64 compareExact(int radius, int lattice, float &exactTotal) {
+	int side = radius * 2;
+	std::array<ChunkBlocks, columnChunks> approx, exact;
+	u64 differ = 0, ticks = 0;
+	for (int i = 0; i < side * side; ++i) {
+		worldgen::setDensityLattice(lattice);
+		generateColumnChunks(i % side - radius, i / side - radius, approx);
+		worldgen::setDensityLattice(1);
+		u64 start = svcGetSystemTick();
+		generateColumnChunks(i % side - radius, i / side - radius, exact);
+		ticks += svcGetSystemTick() - start;
+		for (int c = 0; c < columnChunks; ++c) {
+			for (int z = 0; z < chunkSize; ++z)
+				for (int y = 0; y < chunkSize; ++y)
+					for (int x = 0; x < chunkSize; ++x)
+						differ += approx[c].get(x, y, z).value != exact[c].get(x, y, z).value;
+			approx[c].release();
+			exact[c].release();
+		}
+	}
+	worldgen::setDensityLattice(lattice);
+	exactTotal = ticks * invTickRate;
+	return differ;
+}
+
+int main(int argc, char **argv) {
+
+	int radius = argc > 1 ? atoi(argv[1]) : 16;
+	int lattice = argc > 2 ? atoi(argv[2]) : 1;
+	int threads = argc > 3 ? atoi(argv[3]) : 1;
+
+	worldgen::setDensityLattice(lattice);
+
+	int chunks = radius * radius * 4 * columnChunks, uniform = 0;
+	std::vector<u64> hashes(chunks);
+	std::atomic<int> next = 0;
+
+	u64 start = svcGetSystemTick();
+	generateColumns(radius, next, hashes, uniform);
+	float total = (svcGetSystemTick() - start) * invTickRate;
+
+	printf("%d chunks (%d uniform) in %.3f s, %.0f chunks/s, lattice %d\n",
+		chunks, uniform, total, chunks / total, worldgen::getDensityLattice());
+
+	const char *names[] = { "heightmap", "caves", "ore", "surface", "decoration" };
+	auto stats = worldgen::getStageStats();
+	for (int i = 0; i < (int)worldgen::Stage::Count; ++i) {
+		float t = stats[i].ticks * invTickRate;
+		printf("  %-11s %8u calls %9.2f ms %5.1f%%\n", names[i], stats[i].calls, t * 1000, t / total * 100);
+	}
+
+	auto jobs = worldgen::getColumnJobStats();
+	printf("  %.1f tunnel cells reused per column\n", (float)jobs.cellsReused / jobs.columns);
+
+	auto pool = chunkPool.getStats();
+	printf("  chunk pool: %u allocations, %u live, high water %u, %u slabs\n",
+		pool.allocations, pool.live, pool.highWater, pool.slabs);
+
+	if (worldgen::getDensityLattice() > 1) {
+		float exactTotal;
+		u64 differ = compareExact(radius, worldgen::getDensityLattice(), exactTotal);
+		printf("lattice 1: %.0f chunks/s; lattice %d: %.0f chunks/s, %.3f%% of blocks differ\n",
+			chunks / exactTotal, worldgen::getDensityLattice(), chunks / total,
+			differ * 100.0 / ((u64)chunks * chunkVolume));
+	}
+
+	if (threads < 2)
+		return 0;
+
+	// start over with a cold cache so the parallel run does the same work
+	worldgen::setColumnCacheBudget(worldgen::getColumnCacheStats().budget);
+
+	std::vector<u64> parallel(chunks);
+	std::vector<int> parallelUniform(threads);
+	std::vector<std::thread> workers;
+	next = 0;
+
+	start = svcGetSystemTick();
+	for (int t = 0; t < threads; ++t)
+		workers.emplace_back(generateColumns, radius, std::ref(next), std::ref(parallel), std::ref(parallelUniform[t]));
+	for (auto &t: workers)
+		t.join();
+	float parallelTotal = (svcGetSystemTick() - start) * invTickRate;
+
+	int mismatched = 0;
+	for (int i = 0; i < chunks; ++i)
+		mismatched += hashes[i] != parallel[i];
+
+	printf("%d threads: %.3f s, %.0f chunks/s, %.2fx, %d chunks differ\n",
+		threads, parallelTotal, chunks / parallelTotal, total / parallelTotal, mismatched);
+
+	return mismatched != 0;
+}